@@ -14,7 +14,11 @@
 #include "cxx_argp_parser.h"
 
 #include <condition_variable>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 #include <csignal>
 
@@ -29,6 +33,7 @@ protected:
 	application(size_t expected_argument_count = 0)
 	    : arg_parser(expected_argument_count)
 	{
+		wakeup_pipe_();
 		std::signal(SIGINT, application::signal_handler);
 		std::signal(SIGTERM, application::signal_handler);
 	}
@@ -43,10 +48,119 @@ protected:
 	virtual int main() = 0;
 	virtual bool check_arguments() { return true; }
 
+	// add a command for serve(), build adds its options to a parser which is
+	// built once and reused for each invocation, run is called after the
+	// command line has been parsed successfully; the variables bound by build
+	// keep their values between invocations, also those of a command line
+	// which failed to parse: reset is called before each parse to restore them
+	void add_command(const char *name, const char *doc,
+	                 std::function<void(cxx_argp::parser &)> &&build,
+	                 std::function<void()> &&reset,
+	                 std::function<int(const cxx_argp::parser &)> &&run,
+	                 ssize_t expected_argument_count = 0)
+	{
+		std::unique_ptr<cxx_argp::parser> parser(new cxx_argp::parser(expected_argument_count));
+		parser->add_flags(ARGP_NO_EXIT); // an invalid command or --help must not end the application
+		build(*parser);
+		commands_[name] = {doc, std::move(parser), std::move(reset), std::move(run)};
+	}
+
+	// same for a command without variables to be reset
+	void add_command(const char *name, const char *doc,
+	                 std::function<void(cxx_argp::parser &)> &&build,
+	                 std::function<int(const cxx_argp::parser &)> &&run,
+	                 ssize_t expected_argument_count = 0)
+	{
+		add_command(name, doc, std::move(build), nullptr, std::move(run), expected_argument_count);
+	}
+
+	// read command lines from fd and run them until end-of-file or until the
+	// application is interrupted - also while waiting for a line - "help"
+	// lists the commands unless it is one; returns the result of the last command
+	int serve(int fd = STDIN_FILENO)
+	{
+		int result = EXIT_SUCCESS;
+		if (interrupted())
+			return result;
+
+		read_records(fd, '\n', [this, &result](const char *line) {
+			if (!split_command_line(line, strlen(line), command_arena_, command_argv_)) {
+				fprintf(stderr, "%s: unterminated quote or escape in '%s'\n",
+				        program_invocation_short_name, line);
+				result = EXIT_FAILURE;
+				return !interrupted();
+			}
+
+			if (command_argv_.size() == 1) // blank line
+				return !interrupted();
+
+			auto cmd = commands_.find(command_argv_[0]);
+			if (cmd != commands_.end()) {
+				auto &parser = *cmd->second.parser;
+				if (cmd->second.reset)
+					cmd->second.reset();
+				if (parser.parse(command_argv_.size() - 1, command_argv_.data()))
+					result = cmd->second.run(parser);
+				else if (parser.help_shown()) // "cmd --help" only prints the help
+					result = EXIT_SUCCESS;
+				else
+					result = EXIT_FAILURE;
+			} else if (strcmp(command_argv_[0], "help") == 0) {
+				for (auto &command : commands_)
+					printf("  %-20s %s\n", command.first.c_str(), command.second.doc);
+				result = EXIT_SUCCESS;
+			} else {
+				fprintf(stderr, "%s: unknown command '%s'\n",
+				        program_invocation_short_name, command_argv_[0]);
+				result = EXIT_FAILURE;
+			}
+
+			return !interrupted();
+		}, wakeup_pipe_()[0]);
+
+		return result;
+	}
+
 	static std::mutex main_event_mutex_;        //< mutex for signal handling
 	static std::condition_variable main_event_; //< conditional variable to wakeup the application
 	static bool interrupted_;                   //< used by signal handlers
 
+private:
+	//< self-pipe written when interrupted, wakes up serve() waiting for input
+	static const int *wakeup_pipe_()
+	{
+		static int fds[2] = {-1, -1};
+		static std::once_flag created;
+		std::call_once(created, [] {
+			if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0)
+				fds[0] = fds[1] = -1;
+		});
+		return fds;
+	}
+
+	static void wakeup_()
+	{
+		int fd = wakeup_pipe_()[1];
+		if (fd >= 0) {
+			ssize_t ret = write(fd, "", 1); // a full pipe is readable already
+			(void) ret;
+		}
+	}
+
+	//< commands of serve(), their parsers are kept between invocations
+	struct command_
+	{
+		const char *doc;
+		std::unique_ptr<cxx_argp::parser> parser;
+		std::function<void()> reset;
+		std::function<int(const cxx_argp::parser &)> run;
+	};
+	std::map<std::string, command_> commands_;
+
+	//< words and argv of the current command line, reused for each line
+	std::vector<char> command_arena_;
+	std::vector<char *> command_argv_;
+
 public:
 	const cxx_argp::parser &arguments() const { return arg_parser; }
 
@@ -67,6 +181,7 @@ public:
 		std::lock_guard<std::mutex> lk__(application::main_event_mutex_);
 		application::interrupted_ = true;
 		application::main_event_.notify_all();
+		wakeup_();
 	}
 
 	static bool interrupted() { return application::interrupted_; }
@@ -85,6 +200,7 @@ public:
 		case SIGTERM:
 			application::interrupted_ = true;
 			application::main_event_.notify_all();
+			wakeup_();
 			break;
 		default:
 			// ("unhandled process-signal")
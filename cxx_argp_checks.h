@@ -0,0 +1,213 @@
+// Header-only, modern C++ value-checks for the argument-parser based on ARGP
+//
+// Copyright (C) 2018-2019 Patrick Boettcher <p@yai.se>
+//
+// SPDX-License-Identifier: LGPL-3.0
+//
+// Version: 1.0.0
+//
+// Project website: https://github.com/pboettch/cxx_argp
+#ifndef CXX_ARGP_CHECKS_H__
+#define CXX_ARGP_CHECKS_H__
+
+#include "cxx_argp_parser.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace cxx_argp
+{
+
+/* A check is a type with a static function
+ *
+ *   template <typename T>
+ *   static bool check(const T &value, const char *arg, struct argp_state *state);
+ *
+ * called with the converted value and the argument it was converted from,
+ * which reports a failure with argp_error() and returns false */
+
+/* -1, 0 or 1 if value is less, equal or greater than bound, without the
+ * signed/unsigned-pitfalls of comparing them directly */
+template <typename T>
+inline typename std::enable_if<std::is_unsigned<T>::value, int>::type
+compare_bound(const T &value, long long bound)
+{
+	if (bound < 0)
+		return 1;
+	return value < (unsigned long long) bound ? -1 : value > (unsigned long long) bound;
+}
+
+template <typename T>
+inline typename std::enable_if<!std::is_unsigned<T>::value, int>::type
+compare_bound(const T &value, long long bound)
+{
+	return value < bound ? -1 : value > bound;
+}
+
+/* value is between Min and Max, both included */
+template <long long Min, long long Max>
+struct range
+{
+	template <typename T>
+	static bool check(const T &value, const char *arg, struct argp_state *state)
+	{
+		if (compare_bound(value, Min) >= 0 && compare_bound(value, Max) <= 0)
+			return true;
+		argp_error(state, "'%s' is not between %lld and %lld", arg, Min, Max);
+		return false;
+	}
+};
+
+/* value is one of Values */
+template <long long... Values>
+struct one_of
+{
+	template <typename T>
+	static bool check(const T &value, const char *arg, struct argp_state *state)
+	{
+		for (long long v : {Values...})
+			if (compare_bound(value, v) == 0)
+				return true;
+
+		std::string values;
+		for (long long v : {Values...})
+			values += (values.empty() ? "" : ", ") + std::to_string(v);
+		argp_error(state, "'%s' is not one of %s", arg, values.c_str());
+		return false;
+	}
+};
+
+/* value (string or container) is not empty */
+struct non_empty
+{
+	template <typename T>
+	static bool check(const T &value, const char *, struct argp_state *state)
+	{
+		if (!value.empty())
+			return true;
+		argp_error(state, "empty value not allowed");
+		return false;
+	}
+};
+
+/* value is a power of two */
+struct power_of_two
+{
+	template <typename T>
+	static bool check(const T &value, const char *arg, struct argp_state *state)
+	{
+		if (value > 0 && (value & (value - 1)) == 0)
+			return true;
+		argp_error(state, "'%s' is not a power of two", arg);
+		return false;
+	}
+};
+
+/* the argument names an existing file or directory */
+struct path_exists
+{
+	template <typename T>
+	static bool check(const T &, const char *arg, struct argp_state *state)
+	{
+		if (access(arg, F_OK) == 0)
+			return true;
+		argp_failure(state, 0, errno, "'%s'", arg);
+		return false;
+	}
+};
+
+/* all Checks pass, tried in order until one fails; itself a check */
+template <typename... Checks>
+struct all_of;
+
+template <>
+struct all_of<>
+{
+	template <typename T>
+	static bool check(const T &, const char *, struct argp_state *) { return true; }
+};
+
+template <typename Check, typename... Rest>
+struct all_of<Check, Rest...>
+{
+	template <typename T>
+	static bool check(const T &value, const char *arg, struct argp_state *state)
+	{
+		return Check::check(value, arg, state) && all_of<Rest...>::check(value, arg, state);
+	}
+};
+
+/* whether x can be converted by convert_value(), without a conversion-function */
+template <typename T>
+struct has_convert_value
+{
+	template <typename U>
+	static auto test(int) -> decltype(convert_value(std::declval<U &>(), (const char *) nullptr,
+	                                                (struct argp_state *) nullptr),
+	                                  std::true_type());
+	template <typename>
+	static std::false_type test(...);
+
+	static constexpr bool value = decltype(test<T>(0))::value;
+};
+
+/* conversion-function of x followed by Checks on the converted value, e.g.
+ * parser.add_option({"port", 'p', "PORT", 0, "port"}, cxx_argp::checked<cxx_argp::range<1, 65535>>(port));
+ * numbers and strings are converted and checked inline in one function,
+ * other types use their conversion-function. The argument is converted
+ * into a copy of x which is assigned only if it passes the checks */
+template <typename... Checks, typename T>
+inline typename std::enable_if<has_convert_value<T>::value, arg_parser>::type
+checked(T &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		T value = x;
+		error_t ret = convert_value(value, arg, state);
+		if (ret != 0)
+			return ret;
+		if (!all_of<Checks...>::check(value, arg, state))
+			return EINVAL;
+		x = std::move(value);
+		return 0;
+	};
+}
+
+template <typename... Checks, typename T>
+inline typename std::enable_if<!has_convert_value<T>::value && std::is_copy_assignable<T>::value,
+                               arg_parser>::type
+checked(T &x)
+{
+	return [&x](int key, const char *arg, struct argp_state *state) {
+		T value = x; // conversion-functions may add to the value, e.g. of a list
+		error_t ret = make_check_function(value)(key, arg, state);
+		if (ret != 0)
+			return ret;
+		if (!all_of<Checks...>::check(value, arg, state))
+			return EINVAL;
+		x = std::move(value);
+		return 0;
+	};
+}
+
+/* types which cannot be copied are converted in place */
+template <typename... Checks, typename T>
+inline typename std::enable_if<!has_convert_value<T>::value && !std::is_copy_assignable<T>::value,
+                               arg_parser>::type
+checked(T &x)
+{
+	arg_parser convert = make_check_function(x);
+	return [&x, convert](int key, const char *arg, struct argp_state *state) {
+		error_t ret = convert(key, arg, state);
+		if (ret != 0)
+			return ret;
+		return all_of<Checks...>::check(x, arg, state) ? 0 : EINVAL;
+	};
+}
+
+} // namespace cxx_argp
+
+#endif // CXX_ARGP_CHECKS_H__
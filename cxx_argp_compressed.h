@@ -0,0 +1,514 @@
+// Header-only, modern C++ compressed input-streams for the argument-parser
+// based on ARGP
+//
+// Copyright (C) 2018-2019 Patrick Boettcher <p@yai.se>
+//
+// SPDX-License-Identifier: LGPL-3.0
+//
+// Version: 1.0.0
+//
+// Project website: https://github.com/pboettch/cxx_argp
+//
+// Decompression uses zlib (gzip), liblzma (xz) and libzstd (zstd) for the
+// formats enabled by defining CXX_ARGP_WITH_ZLIB, CXX_ARGP_WITH_LZMA or
+// CXX_ARGP_WITH_ZSTD, the application has to link the libraries of those.
+#ifndef CXX_ARGP_COMPRESSED_H__
+#define CXX_ARGP_COMPRESSED_H__
+
+#include "cxx_argp_parser.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <condition_variable>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef CXX_ARGP_WITH_ZLIB
+#include <zlib.h>
+#define CXX_ARGP_HAS_ZLIB 1
+#endif
+#ifdef CXX_ARGP_WITH_LZMA
+#include <lzma.h>
+#define CXX_ARGP_HAS_LZMA 1
+#endif
+#ifdef CXX_ARGP_WITH_ZSTD
+#include <zstd.h>
+#define CXX_ARGP_HAS_ZSTD 1
+#endif
+
+namespace cxx_argp
+{
+
+/* stream-buffer reading a file which is decompressed by a background-thread
+ * into a bounded ring of blocks, ahead of the consumer */
+class decompressing_streambuf : public std::streambuf
+{
+public:
+	enum format { raw, gzip, xz, zstd };
+
+private:
+	static const size_t block_size = 1 << 17;
+	static const size_t ring_size = 4;
+
+	int fd_ = -1;
+	format format_ = raw;
+	std::string failure_; // set by whoever reads, published as error_
+
+	// input read from the file, consumed by the decoder
+	std::vector<char> in_;
+	size_t in_pos_ = 0, in_size_ = 0;
+	bool in_eof_ = false;
+
+#ifdef CXX_ARGP_HAS_ZLIB
+	z_stream zlib_ = {};
+#endif
+#ifdef CXX_ARGP_HAS_LZMA
+	lzma_stream lzma_ = LZMA_STREAM_INIT;
+#endif
+#ifdef CXX_ARGP_HAS_ZSTD
+	ZSTD_DStream *zstd_ = nullptr;
+	bool zstd_in_frame_ = false; // a frame is not yet completely decoded
+#endif
+	bool decoder_done_ = false;
+
+	// ring of decompressed blocks, produced counts the blocks filled by the
+	// thread, consumed those given back by the consumer
+	struct block
+	{
+		std::vector<char> data;
+		size_t size;
+	};
+	std::vector<block> ring_;
+	size_t produced_ = 0, consumed_ = 0;
+	bool holding_ = false; // consumer reads from ring_[consumed_]
+	bool done_ = true;     // producer finished, or none is running
+	bool stop_ = false;    // consumer closes
+	std::string error_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::thread thread_;
+
+	bool read_input_()
+	{
+		if (in_eof_)
+			return false;
+
+		ssize_t n;
+		do
+			n = ::read(fd_, in_.data(), in_.size());
+		while (n < 0 && errno == EINTR);
+
+		if (n < 0)
+			failure_ = strerror(errno);
+		if (n <= 0) {
+			in_eof_ = true;
+			return false;
+		}
+		in_pos_ = 0;
+		in_size_ = n;
+		return true;
+	}
+
+	bool init_decoder_()
+	{
+		read_input_();
+
+		auto magic = [this](const char *bytes, size_t length) {
+			return in_size_ >= length && memcmp(in_.data(), bytes, length) == 0;
+		};
+
+		if (magic("\x1f\x8b", 2))
+			format_ = gzip;
+		else if (magic("\xfd" "7zXZ\0", 6))
+			format_ = xz;
+		else if (magic("\x28\xb5\x2f\xfd", 4))
+			format_ = zstd;
+
+		switch (format_) {
+		case raw:
+			return true;
+
+		case gzip:
+#ifdef CXX_ARGP_HAS_ZLIB
+			if (inflateInit2(&zlib_, 15 + 32) == Z_OK)
+				return true;
+			failure_ = "unable to initialize zlib";
+#else
+			failure_ = "gzip-support not available";
+#endif
+			return false;
+
+		case xz:
+#ifdef CXX_ARGP_HAS_LZMA
+			if (lzma_stream_decoder(&lzma_, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK)
+				return true;
+			failure_ = "unable to initialize liblzma";
+#else
+			failure_ = "xz-support not available";
+#endif
+			return false;
+
+		case zstd:
+#ifdef CXX_ARGP_HAS_ZSTD
+			zstd_ = ZSTD_createDStream();
+			if (zstd_ && !ZSTD_isError(ZSTD_initDStream(zstd_)))
+				return true;
+			failure_ = "unable to initialize libzstd";
+#else
+			failure_ = "zstd-support not available";
+#endif
+			return false;
+		}
+		return false;
+	}
+
+	void end_decoder_()
+	{
+#ifdef CXX_ARGP_HAS_ZLIB
+		if (format_ == gzip)
+			inflateEnd(&zlib_);
+#endif
+#ifdef CXX_ARGP_HAS_LZMA
+		if (format_ == xz)
+			lzma_end(&lzma_);
+#endif
+#ifdef CXX_ARGP_HAS_ZSTD
+		if (format_ == zstd)
+			ZSTD_freeDStream(zstd_);
+#endif
+	}
+
+	// decompress up to size bytes into out, 0 at the end or on error
+	size_t decode_(char *out, size_t size)
+	{
+		if (format_ == raw) {
+			// the rest of the input read for detection, then directly
+			if (in_pos_ < in_size_) {
+				size_t n = std::min(size, in_size_ - in_pos_);
+				memcpy(out, in_.data() + in_pos_, n);
+				in_pos_ += n;
+				return n;
+			}
+
+			ssize_t n;
+			do
+				n = ::read(fd_, out, size);
+			while (n < 0 && errno == EINTR);
+			if (n < 0)
+				failure_ = strerror(errno);
+			return n > 0 ? n : 0;
+		}
+
+		size_t produced = 0;
+
+		while (produced < size && !decoder_done_ && failure_.empty()) {
+			if (in_pos_ == in_size_)
+				read_input_();
+
+			const size_t available = in_size_ - in_pos_;
+
+			switch (format_) {
+			case raw:
+				break;
+
+			case gzip: {
+#ifdef CXX_ARGP_HAS_ZLIB
+				zlib_.next_in = reinterpret_cast<Bytef *>(in_.data() + in_pos_);
+				zlib_.avail_in = available;
+				zlib_.next_out = reinterpret_cast<Bytef *>(out + produced);
+				zlib_.avail_out = size - produced;
+
+				int ret = inflate(&zlib_, Z_NO_FLUSH);
+
+				in_pos_ = in_size_ - zlib_.avail_in;
+				produced = size - zlib_.avail_out;
+
+				if (ret == Z_STREAM_END) {
+					// concatenated gzip-members
+					if (in_pos_ == in_size_ && !read_input_())
+						decoder_done_ = true;
+					else
+						inflateReset(&zlib_);
+				} else if (ret == Z_BUF_ERROR && in_eof_) {
+					failure_ = "unexpected end of gzip-data";
+				} else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+					failure_ = zlib_.msg ? zlib_.msg : "corrupt gzip-data";
+				}
+#endif
+				break;
+			}
+
+			case xz: {
+#ifdef CXX_ARGP_HAS_LZMA
+				lzma_.next_in = reinterpret_cast<const uint8_t *>(in_.data() + in_pos_);
+				lzma_.avail_in = available;
+				lzma_.next_out = reinterpret_cast<uint8_t *>(out + produced);
+				lzma_.avail_out = size - produced;
+
+				lzma_ret ret = lzma_code(&lzma_, in_eof_ ? LZMA_FINISH : LZMA_RUN);
+
+				in_pos_ = in_size_ - lzma_.avail_in;
+				produced = size - lzma_.avail_out;
+
+				if (ret == LZMA_STREAM_END)
+					decoder_done_ = true;
+				else if (ret != LZMA_OK && ret != LZMA_BUF_ERROR)
+					failure_ = "corrupt xz-data";
+				else if (in_eof_ && produced < size)
+					failure_ = "unexpected end of xz-data";
+#endif
+				break;
+			}
+
+			case zstd: {
+#ifdef CXX_ARGP_HAS_ZSTD
+				ZSTD_inBuffer input = {in_.data(), in_size_, in_pos_};
+				ZSTD_outBuffer output = {out, size, produced};
+
+				size_t ret = ZSTD_decompressStream(zstd_, &output, &input);
+
+				// without progress ret hints at the header of a next frame
+				if (input.pos != in_pos_ || output.pos != produced)
+					zstd_in_frame_ = ret != 0;
+				in_pos_ = input.pos;
+				produced = output.pos;
+
+				if (ZSTD_isError(ret))
+					failure_ = ZSTD_getErrorName(ret);
+				else if (in_eof_ && in_pos_ == in_size_ && produced < size) {
+					if (zstd_in_frame_)
+						failure_ = "unexpected end of zstd-data";
+					decoder_done_ = true;
+				}
+#endif
+				break;
+			}
+			}
+		}
+
+		return produced;
+	}
+
+	// background-thread: fill the free blocks of the ring
+	void produce_()
+	{
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				cv_.wait(lock, [this] { return produced_ - consumed_ < ring_size || stop_; });
+				if (stop_)
+					break;
+			}
+
+			// not in use by the consumer
+			block &b = ring_[produced_ % ring_size];
+			b.size = decode_(b.data.data(), b.data.size());
+			if (b.size == 0)
+				break;
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			produced_++;
+			cv_.notify_all();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		done_ = true;
+		error_ = failure_;
+		cv_.notify_all();
+	}
+
+protected:
+	int_type underflow() override
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		if (holding_) {
+			consumed_++;
+			holding_ = false;
+			cv_.notify_all();
+		}
+
+		cv_.wait(lock, [this] { return produced_ > consumed_ || done_; });
+		if (produced_ == consumed_) {
+			setg(nullptr, nullptr, nullptr);
+			return traits_type::eof();
+		}
+
+		block &b = ring_[consumed_ % ring_size];
+		holding_ = true;
+		setg(b.data.data(), b.data.data(), b.data.data() + b.size);
+		return traits_type::to_int_type(*gptr());
+	}
+
+public:
+	decompressing_streambuf() = default;
+	decompressing_streambuf(const decompressing_streambuf &) = delete;
+	decompressing_streambuf &operator=(const decompressing_streambuf &) = delete;
+
+	~decompressing_streambuf() { close(); }
+
+	// open the file, detect its compression and start decompressing,
+	// on error false is returned and error() tells why
+	bool open(const char *filename)
+	{
+		close();
+
+		fd_ = ::open(filename, O_RDONLY | O_CLOEXEC);
+		if (fd_ < 0) {
+			error_ = strerror(errno);
+			return false;
+		}
+		posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+		in_.resize(block_size);
+		if (!init_decoder_()) {
+			::close(fd_);
+			fd_ = -1;
+			error_ = failure_;
+			return false;
+		}
+
+		ring_.resize(ring_size);
+		for (auto &b : ring_)
+			b.data.resize(block_size);
+
+		done_ = false;
+		thread_ = std::thread(&decompressing_streambuf::produce_, this);
+		return true;
+	}
+
+	void close()
+	{
+		if (thread_.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+				cv_.notify_all();
+			}
+			thread_.join();
+		}
+
+		if (fd_ >= 0) {
+			end_decoder_();
+			::close(fd_);
+		}
+
+		fd_ = -1;
+		format_ = raw;
+		failure_.clear();
+		error_.clear();
+		in_pos_ = in_size_ = 0;
+		in_eof_ = decoder_done_ = false;
+#ifdef CXX_ARGP_HAS_ZSTD
+		zstd_in_frame_ = false;
+#endif
+		produced_ = consumed_ = 0;
+		holding_ = stop_ = false;
+		done_ = true;
+		setg(nullptr, nullptr, nullptr);
+	}
+
+	bool is_open() const { return fd_ >= 0; }
+	format compression() const { return format_; }
+
+	// why opening or decompressing failed, empty if not
+	std::string error()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return error_;
+	}
+};
+
+/* input file-stream decompressing gzip, xz or zstd-files transparently,
+ * other files are read as they are */
+class compressed_ifstream : public std::istream
+{
+	std::unique_ptr<decompressing_streambuf> buf_;
+
+public:
+	compressed_ifstream()
+	    : std::istream(nullptr), buf_(new decompressing_streambuf)
+	{
+		set_rdbuf(buf_.get());
+	}
+
+	explicit compressed_ifstream(const char *filename)
+	    : compressed_ifstream()
+	{
+		open(filename);
+	}
+
+	compressed_ifstream(compressed_ifstream &&other)
+	    : std::istream(std::move(other)), buf_(std::move(other.buf_))
+	{
+		set_rdbuf(buf_.get());
+		other.set_rdbuf(nullptr);
+	}
+
+	compressed_ifstream &operator=(compressed_ifstream &&other)
+	{
+		std::istream::operator=(std::move(other));
+		buf_ = std::move(other.buf_);
+		set_rdbuf(buf_.get());
+		other.set_rdbuf(nullptr);
+		return *this;
+	}
+
+	void open(const char *filename)
+	{
+		if (!buf_)
+			buf_.reset(new decompressing_streambuf);
+		set_rdbuf(buf_.get());
+
+		if (buf_->open(filename))
+			clear();
+		else
+			setstate(std::ios_base::failbit);
+	}
+
+	void close() { if (buf_) buf_->close(); }
+
+	bool is_open() const { return buf_ && buf_->is_open(); }
+
+	decompressing_streambuf::format compression() const
+	{
+		return buf_ ? buf_->compression() : decompressing_streambuf::raw;
+	}
+
+	// why opening or decompressing failed, empty if not
+	std::string error() const { return buf_ ? buf_->error() : std::string(); }
+};
+
+/* specialised for compressed file-streams */
+inline arg_parser make_check_function(compressed_ifstream &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		x.open(arg);
+		if (x.good())
+			return 0;
+		argp_error(state, "unable to open '%s': %s", arg, x.error().c_str());
+		return -1;
+	};
+}
+
+inline error_t lazy_check(const compressed_ifstream *, int, const char *arg,
+                          struct argp_state *state)
+{
+	if (access(arg, R_OK) == 0)
+		return 0;
+	argp_error(state, "unable to open '%s'", arg);
+	return -1;
+}
+
+} // namespace cxx_argp
+
+#endif // CXX_ARGP_COMPRESSED_H__
@@ -0,0 +1,466 @@
+// Header-only, modern C++ container-types for the argument-parser based on ARGP
+//
+// Copyright (C) 2018-2019 Patrick Boettcher <p@yai.se>
+//
+// SPDX-License-Identifier: LGPL-3.0
+//
+// Version: 1.0.0
+//
+// Project website: https://github.com/pboettch/cxx_argp
+#ifndef CXX_ARGP_CONTAINERS_H__
+#define CXX_ARGP_CONTAINERS_H__
+
+#include "cxx_argp_parser.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace cxx_argp
+{
+
+/* storage for strings which never moves them, allocated in blocks */
+class arena
+{
+	std::vector<std::unique_ptr<char[]>> blocks_;
+	size_t left_ = 0;
+	char *next_ = nullptr;
+
+public:
+	// copy of length bytes of s, NUL-terminated
+	const char *store(const char *s, size_t length)
+	{
+		if (length + 1 > left_) {
+			size_t size = std::max<size_t>(4096, length + 1);
+			blocks_.emplace_back(new char[size]);
+			next_ = blocks_.back().get();
+			left_ = size;
+		}
+
+		char *copy = next_;
+		memcpy(copy, s, length);
+		copy[length] = '\0';
+
+		next_ += length + 1;
+		left_ -= length + 1;
+		return copy;
+	}
+
+	void clear()
+	{
+		blocks_.clear();
+		left_ = 0;
+		next_ = nullptr;
+	}
+};
+
+/* FNV-1a hash of length bytes of s */
+inline uint64_t hash_string(const char *s, size_t length)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++)
+		h = (h ^ (unsigned char) s[i]) * 1099511628211ULL;
+	return h;
+}
+
+/* hash-map from string to T with open addressing (linear probing) in one
+ * flat vector, keys - and values of type const char * - are kept in an arena.
+ * Filled by options of the form key=value, the last value of a key wins */
+template <typename T = const char *>
+class flat_map
+{
+public:
+	struct entry
+	{
+		const char *key = nullptr; //< nullptr for free slots
+		size_t length = 0;
+		T value = T();
+	};
+
+private:
+	std::vector<entry> slots_; // size is a power of two, at most half used
+	std::vector<uint64_t> hashes_;
+	size_t size_ = 0;
+	cxx_argp::arena arena_;
+
+	// slot of key or the free one where it belongs
+	size_t slot_(const char *key, size_t length, uint64_t hash) const
+	{
+		size_t mask = slots_.size() - 1;
+		for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+			const entry &e = slots_[i];
+			if (!e.key ||
+			    (hashes_[i] == hash && e.length == length && memcmp(e.key, key, length) == 0))
+				return i;
+		}
+	}
+
+	void grow_()
+	{
+		std::vector<entry> slots(std::max<size_t>(16, slots_.size() * 2));
+		std::vector<uint64_t> hashes(slots.size());
+		slots_.swap(slots);
+		hashes_.swap(hashes);
+
+		for (size_t i = 0; i < slots.size(); i++)
+			if (slots[i].key) {
+				size_t to = slot_(slots[i].key, slots[i].length, hashes[i]);
+				slots_[to] = std::move(slots[i]);
+				hashes_[to] = hashes[i];
+			}
+	}
+
+public:
+	// value of key, inserted if not present
+	T &operator()(const char *key, size_t length)
+	{
+		if ((size_ + 1) * 2 > slots_.size())
+			grow_();
+
+		uint64_t hash = hash_string(key, length);
+		size_t i = slot_(key, length, hash);
+		if (!slots_[i].key) {
+			slots_[i].key = arena_.store(key, length);
+			slots_[i].length = length;
+			hashes_[i] = hash;
+			size_++;
+		}
+		return slots_[i].value;
+	}
+
+	// copy of text kept as long as the map, for values of type const char *
+	const char *store(const char *text) { return arena_.store(text, strlen(text)); }
+
+	const T *find(const char *key, size_t length) const
+	{
+		if (size_ == 0)
+			return nullptr;
+
+		size_t i = slot_(key, length, hash_string(key, length));
+		return slots_[i].key ? &slots_[i].value : nullptr;
+	}
+
+	const T *find(const char *key) const { return find(key, strlen(key)); }
+	const T *find(const std::string &key) const { return find(key.data(), key.size()); }
+#if __cplusplus >= 201703L
+	const T *find(std::string_view key) const { return find(key.data(), key.size()); }
+#endif
+
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	void clear()
+	{
+		slots_.clear();
+		hashes_.clear();
+		arena_.clear();
+		size_ = 0;
+	}
+
+	// call f(key, value) for each entry, in no particular order
+	template <typename F>
+	void for_each(F &&f) const
+	{
+		for (auto &e : slots_)
+			if (e.key)
+				f(e.key, e.value);
+	}
+};
+
+/* value of a key=value-option converted by the conversion-function of T */
+template <typename T>
+inline error_t convert_map_value(flat_map<T> &, T &value, int key, const char *text,
+                                 struct argp_state *state)
+{
+	return make_check_function(value)(key, text, state);
+}
+
+/* value of a key=value-option kept as text */
+inline error_t convert_map_value(flat_map<const char *> &x, const char *&value, int,
+                                 const char *text, struct argp_state *)
+{
+	value = x.store(text);
+	return 0;
+}
+
+/* for key=value-options, the option can be repeated, the last value of a key wins */
+template <typename T>
+inline arg_parser make_check_function(flat_map<T> &x)
+{
+	return [&x](int key, const char *arg, struct argp_state *state) {
+		const char *equal = strchr(arg, '=');
+		if (!equal || equal == arg) {
+			argp_error(state, "'%s' is not of the form key=value", arg);
+			return EINVAL;
+		}
+
+		T value = T();
+		error_t ret = convert_map_value(x, value, key, equal + 1, state);
+		if (ret == 0)
+			x(arg, equal - arg) = std::move(value);
+		return ret;
+	};
+}
+
+/* hash-set of integers or strings (const char *, kept in an arena) with open
+ * addressing (linear probing) in one flat vector, optionally with a
+ * Bloom-filter in front which rejects most absent values with two
+ * bit-tests in a table 8 times smaller than the set. Filled by options
+ * with a comma-separated list or @file with one value per line */
+template <typename T = const char *>
+class flat_set
+{
+	static_assert(std::is_integral<T>::value || std::is_same<T, const char *>::value,
+	              "flat_set holds integers or const char *");
+
+	std::vector<T> slots_; //< size is a power of two, at most half used
+	size_t size_ = 0;
+	bool free_value_used_ = false; //< free_() itself is in the set (integers)
+
+	bool bloom_;
+	std::vector<uint64_t> bloom_bits_; //< 8 bits per slot
+
+	cxx_argp::arena arena_;
+
+	// value marking free slots
+	static T free_() { return free_(std::is_integral<T>()); }
+	static T free_(std::true_type) { return std::numeric_limits<T>::max(); }
+	static T free_(std::false_type) { return T(); }
+
+	static uint64_t hash_(uint64_t v) // splitmix64
+	{
+		v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		v = (v ^ (v >> 27)) * 0x94d049bb133111ebULL;
+		return v ^ (v >> 31);
+	}
+
+	static uint64_t hash_of_(T value, std::true_type) { return hash_(uint64_t(value)); }
+	static uint64_t hash_of_(T value, std::false_type) { return hash_string(value, strlen(value)); }
+
+	void bloom_set_(uint64_t hash)
+	{
+		size_t mask = bloom_bits_.size() * 64 - 1;
+		size_t a = hash & mask, b = (hash >> 32) & mask;
+		bloom_bits_[a / 64] |= uint64_t(1) << (a % 64);
+		bloom_bits_[b / 64] |= uint64_t(1) << (b % 64);
+	}
+
+	bool bloom_test_(uint64_t hash) const
+	{
+		size_t mask = bloom_bits_.size() * 64 - 1;
+		size_t a = hash & mask, b = (hash >> 32) & mask;
+		return (bloom_bits_[a / 64] >> (a % 64) & 1) && (bloom_bits_[b / 64] >> (b % 64) & 1);
+	}
+
+	// slot of the value equal() accepts or the free one where it belongs
+	template <typename Equal>
+	size_t slot_(uint64_t hash, Equal &&equal) const
+	{
+		size_t mask = slots_.size() - 1;
+		for (size_t i = hash & mask; ; i = (i + 1) & mask)
+			if (slots_[i] == free_() || equal(slots_[i]))
+				return i;
+	}
+
+	void grow_()
+	{
+		std::vector<T> slots(std::max<size_t>(16, slots_.size() * 2), free_());
+		slots_.swap(slots);
+		if (bloom_)
+			bloom_bits_.assign(slots_.size() / 8, 0);
+
+		for (auto value : slots)
+			if (value != free_()) {
+				uint64_t hash = hash_of_(value, std::is_integral<T>());
+				slots_[slot_(hash, [](T) { return false; })] = value;
+				if (bloom_)
+					bloom_set_(hash);
+			}
+	}
+
+	// insert value with hash unless equal() finds it, stored by store()
+	template <typename Equal, typename Store>
+	void insert_(uint64_t hash, Equal &&equal, Store &&store)
+	{
+		if ((size_ + 1) * 2 > slots_.size())
+			grow_();
+
+		size_t i = slot_(hash, equal);
+		if (slots_[i] != free_())
+			return;
+
+		slots_[i] = store();
+		size_++;
+		if (bloom_)
+			bloom_set_(hash);
+	}
+
+	template <typename Equal>
+	bool contains_(uint64_t hash, Equal &&equal) const
+	{
+		if (size_ == 0 || (bloom_ && !bloom_test_(hash)))
+			return false;
+		return slots_[slot_(hash, equal)] != free_();
+	}
+
+public:
+	explicit flat_set(bool bloom = false) : bloom_(bloom) {}
+
+	void insert(T value) { insert_value_(value, std::is_integral<T>()); }
+	bool contains(T value) const { return contains_value_(value, std::is_integral<T>()); }
+
+	// for strings, a copy of length bytes of s is kept
+	void insert(const char *s, size_t length)
+	{
+		insert_(hash_string(s, length),
+		        [s, length](T v) { return strncmp(v, s, length) == 0 && v[length] == '\0'; },
+		        [this, s, length]() { return arena_.store(s, length); });
+	}
+
+	bool contains(const char *s, size_t length) const
+	{
+		return contains_(hash_string(s, length),
+		                 [s, length](T v) { return strncmp(v, s, length) == 0 && v[length] == '\0'; });
+	}
+
+	bool contains(const std::string &s) const { return contains(s.data(), s.size()); }
+#if __cplusplus >= 201703L
+	bool contains(std::string_view s) const { return contains(s.data(), s.size()); }
+#endif
+
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+private:
+	void insert_value_(const char *s, std::false_type) { insert(s, strlen(s)); }
+	bool contains_value_(const char *s, std::false_type) const { return contains(s, strlen(s)); }
+
+	void insert_value_(T value, std::true_type)
+	{
+		if (value == free_()) {
+			size_ += !free_value_used_;
+			free_value_used_ = true;
+			return;
+		}
+		insert_(hash_(uint64_t(value)),
+		        [value](T v) { return v == value; },
+		        [value]() { return value; });
+	}
+
+	bool contains_value_(T value, std::true_type) const
+	{
+		if (value == free_())
+			return free_value_used_;
+		return contains_(hash_(uint64_t(value)), [value](T v) { return v == value; });
+	}
+};
+
+/* adds the value of length bytes at text to x, false if it is invalid */
+template <typename T>
+inline bool insert_set_value(flat_set<T> &x, const char *text, size_t length)
+{
+	char buffer[32]; // NUL-terminated for strto*()
+	if (length == 0 || length >= sizeof(buffer))
+		return false;
+	memcpy(buffer, text, length);
+	buffer[length] = '\0';
+
+	char *end;
+	errno = 0;
+	T value;
+	if (std::is_signed<T>::value) {
+		long long v = strtoll(buffer, &end, 10);
+		value = T(v);
+		if (v < (long long) std::numeric_limits<T>::min() ||
+		    v > (long long) std::numeric_limits<T>::max())
+			errno = ERANGE;
+	} else {
+		unsigned long long v = strtoull(buffer, &end, 10);
+		value = T(v);
+		if (buffer[0] == '-' || v > (unsigned long long) std::numeric_limits<T>::max())
+			errno = ERANGE;
+	}
+	if (*end != '\0' || errno != 0)
+		return false;
+
+	x.insert(value);
+	return true;
+}
+
+inline bool insert_set_value(flat_set<const char *> &x, const char *text, size_t length)
+{
+	x.insert(text, length);
+	return true;
+}
+
+/* for sets, a comma-separated list of values or @file with one value per line,
+ * blanks around them and lines starting with # are ignored; the option can be
+ * repeated */
+template <typename T>
+inline arg_parser make_check_function(flat_set<T> &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		auto add = [&x](const char *begin, const char *end) {
+			while (begin < end && isspace(*begin))
+				begin++;
+			while (end > begin && isspace(end[-1]))
+				end--;
+			return begin == end || *begin == '#' || insert_set_value(x, begin, end - begin);
+		};
+
+		if (arg[0] != '@') {
+			for (const char *begin = arg; ; ) {
+				const char *end = strchrnul(begin, ',');
+				if (!add(begin, end)) {
+					argp_error(state, "invalid value '%.*s'", (int) (end - begin), begin);
+					return EINVAL;
+				}
+				if (*end == '\0')
+					return 0;
+				begin = end + 1;
+			}
+		}
+
+		int fd = open(arg + 1, O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			argp_error(state, "unable to open '%s'", arg + 1);
+			return EINVAL;
+		}
+
+		// records only live during the call
+		bool valid = true;
+		std::string invalid;
+		int err = read_records(fd, '\n', [&](const char *record) {
+			valid = add(record, record + strlen(record));
+			if (!valid)
+				invalid = record;
+			return valid;
+		});
+		close(fd);
+
+		if (err != 0) {
+			argp_failure(state, 0, err, "unable to read '%s'", arg + 1);
+			return err;
+		}
+		if (!valid) {
+			argp_error(state, "invalid value '%s' in '%s'", invalid.c_str(), arg + 1);
+			return EINVAL;
+		}
+		return 0;
+	};
+}
+
+} // namespace cxx_argp
+
+#endif // CXX_ARGP_CONTAINERS_H__
@@ -0,0 +1,223 @@
+// Header-only, modern C++ binary-data decoders for the argument-parser based on ARGP
+//
+// Copyright (C) 2018-2019 Patrick Boettcher <p@yai.se>
+//
+// SPDX-License-Identifier: LGPL-3.0
+//
+// Version: 1.0.0
+//
+// Project website: https://github.com/pboettch/cxx_argp
+#ifndef CXX_ARGP_ENCODING_H__
+#define CXX_ARGP_ENCODING_H__
+
+#include "cxx_argp_parser.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cxx_argp
+{
+
+/* value of a hex-digit, -1 if it is none */
+inline int hex_value(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+/* decodes length hex-digits at text (length even) into length / 2 bytes at
+ * out, returns the offset of the first invalid character or length */
+inline size_t decode_hex(const char *text, size_t length, uint8_t *out)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	// 16 digits at a time to 8 bytes
+	const __m128i zero = _mm_set1_epi8('0' - 1), nine = _mm_set1_epi8('9' + 1);
+	const __m128i a = _mm_set1_epi8('a' - 1), f = _mm_set1_epi8('f' + 1);
+	const __m128i lower = _mm_set1_epi8(0x20);
+
+	for (; i + 16 <= length; i += 16) {
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+		__m128i l = _mm_or_si128(c, lower);
+
+		// characters >= 0x80 are negative and thus no digits
+		__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, zero), _mm_cmplt_epi8(c, nine));
+		__m128i letter = _mm_and_si128(_mm_cmpgt_epi8(l, a), _mm_cmplt_epi8(l, f));
+		if (_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xffff)
+			break; // the scalar loop finds the invalid one
+
+		__m128i value = _mm_or_si128(
+		    _mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+		    _mm_and_si128(letter, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10))));
+
+		// first digit of a pair is the low byte of a 16-bit lane
+		__m128i high = _mm_slli_epi16(_mm_and_si128(value, _mm_set1_epi16(0x00ff)), 4);
+		__m128i bytes = _mm_or_si128(high, _mm_srli_epi16(value, 8));
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(out + i / 2), _mm_packus_epi16(bytes, bytes));
+	}
+#endif
+
+	for (; i + 1 < length; i += 2) {
+		int high = hex_value(text[i]), low = hex_value(text[i + 1]);
+		if (high < 0)
+			return i;
+		if (low < 0)
+			return i + 1;
+		out[i / 2] = high << 4 | low;
+	}
+
+	return length;
+}
+
+/* values of the base64-characters, -1 for the others */
+inline const int8_t *base64_values()
+{
+	static const struct table
+	{
+		int8_t value[256];
+
+		table()
+		{
+			memset(value, -1, sizeof(value));
+			const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (int i = 0; i < 64; i++)
+				value[(unsigned char) alphabet[i]] = i;
+		}
+	} decode;
+
+	return decode.value;
+}
+
+/* size of the data encoded in length characters of padded base64 at text,
+ * 0 if length is not a multiple of 4 */
+inline size_t base64_size(const char *text, size_t length)
+{
+	if (length == 0 || length % 4 != 0)
+		return 0;
+	return length / 4 * 3 - (text[length - 1] == '=') - (text[length - 2] == '=');
+}
+
+/* decodes length characters of padded base64 at text into base64_size() bytes
+ * at out, returns the offset of the first invalid character or length */
+inline size_t decode_base64(const char *text, size_t length, uint8_t *out)
+{
+	size_t size = base64_size(text, length);
+	if (size == 0)
+		return length == 0 ? 0 : length - length % 4;
+
+	const int8_t *value = base64_values();
+	auto v = [value](char c) { return value[(unsigned char) c]; };
+
+	// 4 characters at a time to 3 bytes, the last group may be padded
+	for (size_t i = 0; i < length; i += 4, out += 3) {
+		int v0 = v(text[i]), v1 = v(text[i + 1]), v2 = v(text[i + 2]), v3 = v(text[i + 3]);
+
+		bool last = i + 4 == length;
+		if (last && text[i + 3] == '=') {
+			v3 = 0;
+			if (text[i + 2] == '=')
+				v2 = 0;
+		}
+
+		if ((v0 | v1 | v2 | v3) < 0) {
+			for (size_t j = i; ; j++)
+				if (v(text[j]) < 0)
+					return j;
+		}
+
+		uint32_t bits = uint32_t(v0) << 18 | uint32_t(v1) << 12 | uint32_t(v2) << 6 | uint32_t(v3);
+		out[0] = bits >> 16;
+		if (!last || size % 3 != 1)
+			out[1] = bits >> 8;
+		if (!last || size % 3 == 0)
+			out[2] = bits;
+	}
+
+	return length;
+}
+
+/* makes x hold size decoded bytes, an array must have exactly that size */
+inline bool resize_blob(std::vector<uint8_t> &x, size_t size, const char *, struct argp_state *)
+{
+	x.resize(size);
+	return true;
+}
+
+template <size_t N>
+inline bool resize_blob(std::array<uint8_t, N> &, size_t size, const char *encoding,
+                        struct argp_state *state)
+{
+	if (size == N)
+		return true;
+	argp_error(state, "%s-data decodes to %zu bytes instead of %zu", encoding, size, N);
+	return false;
+}
+
+/* decodes arg into x, a vector or an array */
+template <typename C>
+inline error_t decode_into(C &x, bool base64, const char *arg, struct argp_state *state)
+{
+	const char *encoding = base64 ? "base64" : "hex";
+	size_t length = strlen(arg);
+
+	if (length % (base64 ? 4 : 2) != 0) {
+		argp_error(state, "%s-data of length %zu is truncated", encoding, length);
+		return EINVAL;
+	}
+	if (!resize_blob(x, base64 ? base64_size(arg, length) : length / 2, encoding, state))
+		return EINVAL;
+
+	size_t invalid = base64 ? decode_base64(arg, length, x.data()) : decode_hex(arg, length, x.data());
+	if (invalid != length) {
+		argp_error(state, "invalid %s-character '%c' at offset %zu", encoding, arg[invalid], invalid);
+		return EINVAL;
+	}
+	return 0;
+}
+
+/* conversion-functions for binary data given as hex or padded base64,
+ * e.g. parser.add_option({"key", 'k', "HEX", 0, "key"}, cxx_argp::hex(key)); */
+inline arg_parser hex(std::vector<uint8_t> &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		return decode_into(x, false, arg, state);
+	};
+}
+
+template <size_t N>
+inline arg_parser hex(std::array<uint8_t, N> &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		return decode_into(x, false, arg, state);
+	};
+}
+
+inline arg_parser base64(std::vector<uint8_t> &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		return decode_into(x, true, arg, state);
+	};
+}
+
+template <size_t N>
+inline arg_parser base64(std::array<uint8_t, N> &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		return decode_into(x, true, arg, state);
+	};
+}
+
+} // namespace cxx_argp
+
+#endif // CXX_ARGP_ENCODING_H__
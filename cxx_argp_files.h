@@ -0,0 +1,492 @@
+// Header-only, modern C++ file-types for the argument-parser based on ARGP
+//
+// Copyright (C) 2018-2019 Patrick Boettcher <p@yai.se>
+//
+// SPDX-License-Identifier: LGPL-3.0
+//
+// Version: 1.0.0
+//
+// Project website: https://github.com/pboettch/cxx_argp
+#ifndef CXX_ARGP_FILES_H__
+#define CXX_ARGP_FILES_H__
+
+#include "cxx_argp_parser.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace cxx_argp
+{
+
+/* a file mapped read-only into memory */
+class mapped_file
+{
+public:
+	// hints given to the kernel with madvise()
+	enum advice : unsigned {
+		sequential = 1 << 0,
+		random = 1 << 1,
+		willneed = 1 << 2,
+		hugepage = 1 << 3,
+	};
+
+private:
+	unsigned advice_;
+	void *data_ = nullptr;
+	size_t size_ = 0;
+	std::string name_;
+
+public:
+	explicit mapped_file(unsigned advice = sequential | willneed)
+	    : advice_(advice) {}
+
+	mapped_file(mapped_file &&other) { *this = std::move(other); }
+
+	mapped_file &operator=(mapped_file &&other)
+	{
+		close();
+		advice_ = other.advice_;
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		std::swap(name_, other.name_);
+		return *this;
+	}
+
+	~mapped_file() { close(); }
+
+	// map the whole file, on error false is returned and errno is set
+	bool open(const char *filename)
+	{
+		close();
+
+		int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			int err = errno;
+			::close(fd);
+			errno = err;
+			return false;
+		}
+
+		// an empty file cannot be mapped, but is a valid (empty) file
+		if (st.st_size > 0) {
+			void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				int err = errno;
+				::close(fd);
+				errno = err;
+				return false;
+			}
+			data_ = data;
+			size_ = st.st_size;
+		}
+		::close(fd); // the mapping stays valid
+
+		// hints are not essential, errors are ignored
+		if (data_) {
+			if (advice_ & sequential)
+				madvise(data_, size_, MADV_SEQUENTIAL);
+			if (advice_ & random)
+				madvise(data_, size_, MADV_RANDOM);
+			if (advice_ & willneed)
+				madvise(data_, size_, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+			if (advice_ & hugepage)
+				madvise(data_, size_, MADV_HUGEPAGE);
+#endif
+		}
+
+		name_ = filename;
+		return true;
+	}
+
+	void close()
+	{
+		if (data_)
+			munmap(data_, size_);
+		data_ = nullptr;
+		size_ = 0;
+		name_.clear();
+	}
+
+	bool is_open() const { return !name_.empty(); }
+
+	const char *data() const { return static_cast<const char *>(data_); }
+	size_t size() const { return size_; }
+
+	const char *begin() const { return data(); }
+	const char *end() const { return data() + size_; }
+
+#if __cplusplus >= 201703L
+	std::string_view view() const { return {data(), size_}; }
+#endif
+
+	// filename given to open()
+	const std::string &name() const { return name_; }
+};
+
+/* specialised for mapped files */
+inline arg_parser make_check_function(mapped_file &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		if (x.open(arg))
+			return 0;
+		argp_error(state, "unable to map '%s': %s", arg, strerror(errno));
+		return -1;
+	};
+}
+
+inline error_t lazy_check(const mapped_file *, int, const char *arg, struct argp_state *state)
+{
+	if (access(arg, R_OK) == 0)
+		return 0;
+	argp_error(state, "unable to open '%s'", arg);
+	return -1;
+}
+
+/* a raw file-descriptor, opened with the flags given to the constructor */
+class file_descriptor
+{
+	int flags_;
+	mode_t mode_;
+	off_t preallocate_;
+	int advice_;
+
+	int fd_ = -1;
+	std::string name_;
+
+public:
+	// flags and mode are passed to open(), a file opened for writing is
+	// preallocated to the given size with posix_fallocate(), advice is
+	// passed to posix_fadvise() for the whole file
+	explicit file_descriptor(int flags = O_RDONLY | O_CLOEXEC, mode_t mode = 0666,
+	                         off_t preallocate = 0, int advice = POSIX_FADV_NORMAL)
+	    : flags_(flags), mode_(mode), preallocate_(preallocate), advice_(advice) {}
+
+	file_descriptor(file_descriptor &&other) { *this = std::move(other); }
+
+	file_descriptor &operator=(file_descriptor &&other)
+	{
+		close();
+		flags_ = other.flags_;
+		mode_ = other.mode_;
+		preallocate_ = other.preallocate_;
+		advice_ = other.advice_;
+		std::swap(fd_, other.fd_);
+		std::swap(name_, other.name_);
+		return *this;
+	}
+
+	~file_descriptor() { close(); }
+
+	// open the file, on error false is returned and errno is set
+	bool open(const char *filename)
+	{
+		close();
+
+		int fd = ::open(filename, flags_, mode_);
+		if (fd < 0)
+			return false;
+
+		if (preallocate_ > 0 && (flags_ & O_ACCMODE) != O_RDONLY) {
+			int err = posix_fallocate(fd, 0, preallocate_);
+			if (err != 0) {
+				::close(fd);
+				errno = err;
+				return false;
+			}
+		}
+
+		// the advice is a hint, errors are ignored
+		if (advice_ != POSIX_FADV_NORMAL)
+			posix_fadvise(fd, 0, 0, advice_);
+
+		fd_ = fd;
+		name_ = filename;
+		return true;
+	}
+
+	void close()
+	{
+		if (fd_ >= 0)
+			::close(fd_);
+		fd_ = -1;
+		name_.clear();
+	}
+
+	// take ownership of an already opened file-descriptor
+	void reset(int fd, const char *filename)
+	{
+		close();
+		fd_ = fd;
+		name_ = filename;
+	}
+
+	// give up ownership of the file-descriptor
+	int release()
+	{
+		int fd = fd_;
+		fd_ = -1;
+		name_.clear();
+		return fd;
+	}
+
+	bool is_open() const { return fd_ >= 0; }
+	int get() const { return fd_; }
+
+	// filename given to open()
+	const std::string &name() const { return name_; }
+};
+
+/* specialised for file-descriptors */
+inline arg_parser make_check_function(file_descriptor &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		if (x.open(arg))
+			return 0;
+		argp_error(state, "unable to open '%s': %s", arg, strerror(errno));
+		return -1;
+	};
+}
+
+/* a list of files, opened all at once after parsing: asynchronously with
+ * io_uring if available, otherwise with a pool of threads */
+class file_list
+{
+public:
+	struct file
+	{
+		file_descriptor descriptor;
+		struct stat status;
+	};
+
+private:
+	int flags_;
+	bool io_uring_;
+
+	std::vector<std::string> pending_;
+	std::vector<file> files_;
+
+	// open names[i] into fds[i], -errno on error - returns false if
+	// io_uring or its openat-operation (linux 5.6) is not available or
+	// failed, the files opened until then are left in fds
+	static bool open_io_uring_(const std::vector<std::string> &names, int flags,
+	                           std::vector<int> &fds)
+	{
+#if defined(__NR_io_uring_setup) && defined(IO_URING_OP_SUPPORTED)
+		struct io_uring_params params = {};
+		int ring = syscall(__NR_io_uring_setup, std::min<size_t>(names.size(), 256), &params);
+		if (ring < 0)
+			return false;
+
+		union {
+			struct io_uring_probe probe;
+			char buffer[sizeof(struct io_uring_probe) +
+			            (IORING_OP_OPENAT + 1) * sizeof(struct io_uring_probe_op)];
+		} probe = {};
+		if (syscall(__NR_io_uring_register, ring, IORING_REGISTER_PROBE, &probe, IORING_OP_OPENAT + 1) != 0 ||
+		    probe.probe.last_op < IORING_OP_OPENAT ||
+		    !(probe.probe.ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED)) {
+			close(ring);
+			return false;
+		}
+
+		size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+		size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+		const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+		if (single_mmap)
+			sq_size = cq_size = std::max(sq_size, cq_size);
+
+		char *sq = static_cast<char *>(mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+		                                    MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING));
+		char *cq = single_mmap || sq == MAP_FAILED
+		               ? sq
+		               : static_cast<char *>(mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+		                                          MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING));
+		void *sqes_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+		                      MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+
+		bool ok = sq != MAP_FAILED && cq != MAP_FAILED && sqes_map != MAP_FAILED;
+		if (ok) {
+			unsigned *sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+			unsigned sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+			unsigned *sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+			unsigned *cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+			unsigned *cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+			unsigned cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+			auto cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+			auto sqes = static_cast<struct io_uring_sqe *>(sqes_map);
+
+			// batches of the submission-queue's size
+			for (size_t first = 0; ok && first < names.size(); first += params.sq_entries) {
+				const unsigned count = std::min<size_t>(params.sq_entries, names.size() - first);
+
+				unsigned tail = *sq_tail;
+				for (unsigned i = 0; i < count; i++, tail++) {
+					unsigned index = tail & sq_mask;
+					struct io_uring_sqe *sqe = &sqes[index];
+					memset(sqe, 0, sizeof(*sqe));
+					sqe->opcode = IORING_OP_OPENAT;
+					sqe->fd = AT_FDCWD;
+					sqe->addr = reinterpret_cast<unsigned long>(names[first + i].c_str());
+					sqe->len = 0666; // mode
+					sqe->open_flags = flags;
+					sqe->user_data = first + i;
+					sq_array[index] = index;
+				}
+				__atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+				unsigned submit = count, completed = 0;
+				while (ok && completed < count) {
+					int ret = syscall(__NR_io_uring_enter, ring, submit, count - completed,
+					                  IORING_ENTER_GETEVENTS, nullptr, 0);
+					if (ret < 0) {
+						ok = errno == EINTR;
+						continue;
+					}
+					submit -= std::min<unsigned>(ret, submit);
+
+					unsigned head = *cq_head;
+					for (; head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE); head++, completed++) {
+						auto &cqe = cqes[head & cq_mask];
+						fds[cqe.user_data] = cqe.res;
+					}
+					__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+				}
+			}
+		}
+
+		if (sqes_map != MAP_FAILED)
+			munmap(sqes_map, sqes_size);
+		if (cq != MAP_FAILED && cq != sq)
+			munmap(cq, cq_size);
+		if (sq != MAP_FAILED)
+			munmap(sq, sq_size);
+		close(ring);
+
+		return ok;
+#else
+		(void) names;
+		(void) flags;
+		(void) fds;
+		return false;
+#endif
+	}
+
+	// same with a pool of threads, blocking in open() concurrently; files
+	// already opened (by an io_uring interrupted by an error) are kept
+	static void open_threads_(const std::vector<std::string> &names, int flags,
+	                          std::vector<int> &fds)
+	{
+		std::atomic<size_t> next{0};
+
+		auto work = [&]() {
+			for (size_t i; (i = next++) < names.size();) {
+				if (fds[i] >= 0)
+					continue;
+				int fd = ::open(names[i].c_str(), flags, 0666);
+				fds[i] = fd < 0 ? -errno : fd;
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (size_t i = 1; i < std::min<size_t>(names.size(), 16); i++)
+			pool.emplace_back(work);
+		work();
+		for (auto &thread : pool)
+			thread.join();
+	}
+
+public:
+	// flags are passed to open() for each file
+	explicit file_list(int flags = O_RDONLY | O_CLOEXEC, bool io_uring = true)
+	    : flags_(flags), io_uring_(io_uring) {}
+
+	// add a file to be opened by open()
+	void add(const char *filename) { pending_.push_back(filename); }
+
+	// open all added files, returns the names of the files which
+	// could not be opened (or stat'ed) with their errno
+	std::vector<std::pair<std::string, int>> open()
+	{
+		std::vector<std::pair<std::string, int>> failures;
+		std::vector<int> fds(pending_.size(), -EBADF);
+
+		if (!io_uring_ || !open_io_uring_(pending_, flags_, fds))
+			open_threads_(pending_, flags_, fds);
+
+		files_.reserve(files_.size() + pending_.size());
+		for (size_t i = 0; i < pending_.size(); i++) {
+			struct stat status;
+			if (fds[i] >= 0 && fstat(fds[i], &status) != 0) {
+				int err = errno;
+				::close(fds[i]);
+				fds[i] = -err;
+			}
+
+			if (fds[i] < 0) {
+				failures.push_back({pending_[i], -fds[i]});
+				continue;
+			}
+
+			files_.push_back({file_descriptor{flags_}, status});
+			files_.back().descriptor.reset(fds[i], pending_[i].c_str());
+		}
+		pending_.clear();
+
+		return failures;
+	}
+
+	const std::vector<file> &files() const { return files_; }
+
+	size_t size() const { return files_.size(); }
+	const file &operator[](size_t i) const { return files_[i]; }
+	std::vector<file>::const_iterator begin() const { return files_.begin(); }
+	std::vector<file>::const_iterator end() const { return files_.end(); }
+};
+
+/* specialised for lists of files: each argument is added, all of them are
+ * opened at the end of the argv-scan and each failure is reported */
+inline arg_parser make_check_function(file_list &x)
+{
+	return [&x](int key, const char *arg, struct argp_state *state) {
+		if (key != ARGP_KEY_END) {
+			x.add(arg);
+			return 0;
+		}
+
+		auto failures = x.open();
+		if (failures.empty())
+			return 0;
+
+		for (auto &failure : failures)
+			argp_failure(state, 0, failure.second, "unable to open '%s'", failure.first.c_str());
+		argp_error(state, "unable to open %zu file(s)", failures.size());
+		return EINVAL;
+	};
+}
+
+inline unsigned option_attributes(const file_list *) { return finalize; }
+
+} // namespace cxx_argp
+
+#endif // CXX_ARGP_FILES_H__
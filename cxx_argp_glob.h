@@ -0,0 +1,223 @@
+// Header-only, modern C++ glob-pattern sets for the argument-parser based on ARGP
+//
+// Copyright (C) 2018-2019 Patrick Boettcher <p@yai.se>
+//
+// SPDX-License-Identifier: LGPL-3.0
+//
+// Version: 1.0.0
+//
+// Project website: https://github.com/pboettch/cxx_argp
+#ifndef CXX_ARGP_GLOB_H__
+#define CXX_ARGP_GLOB_H__
+
+#include "cxx_argp_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cxx_argp
+{
+
+/* set of glob-patterns (*, ?, [...] and \-escapes, as fnmatch() without
+ * flags) matched all at once: the patterns form one automaton whose
+ * deterministic states are built lazily while matching and cached, a
+ * string is then matched in one pass regardless of the number of patterns.
+ * matches() updates the cache and is therefore not const, a glob_set is
+ * not to be used by several threads at once */
+class glob_set
+{
+	// element of a pattern: one character of a set, any number of
+	// characters or the end of the pattern
+	struct element_
+	{
+		enum { set, star, end } kind;
+		std::bitset<256> chars;
+	};
+	std::vector<element_> elements_; //< all patterns, each terminated by end
+
+	// deterministic state: the elements reached and the transitions, -1 not yet built
+	struct state_
+	{
+		bool accepting;
+		std::array<int32_t, 256> next;
+	};
+	std::vector<state_> states_;
+	std::map<std::vector<uint32_t>, int32_t> known_;
+	std::vector<const std::vector<uint32_t> *> reached_; //< by state, keys of known_
+
+	static const size_t max_states_ = 4096; //< cache is flushed when reached
+
+	size_t patterns_ = 0;
+
+	// add element i and those reachable without consuming a character
+	void close_(uint32_t i, std::vector<uint32_t> &reached) const
+	{
+		for (;;) {
+			reached.push_back(i);
+			if (elements_[i].kind != element_::star)
+				return;
+			i++; // a star matches nothing as well
+		}
+	}
+
+	int32_t state_of_(std::vector<uint32_t> &&reached)
+	{
+		std::sort(reached.begin(), reached.end());
+		reached.erase(std::unique(reached.begin(), reached.end()), reached.end());
+
+		auto known = known_.find(reached);
+		if (known != known_.end())
+			return known->second;
+
+		state_ state;
+		state.accepting = false;
+		state.next.fill(-1);
+		for (auto i : reached)
+			if (elements_[i].kind == element_::end)
+				state.accepting = true;
+
+		int32_t id = states_.size();
+		states_.push_back(state);
+		reached_.push_back(&known_.insert({std::move(reached), id}).first->first);
+		return id;
+	}
+
+	void flush_()
+	{
+		states_.clear();
+		known_.clear();
+		reached_.clear();
+	}
+
+	int32_t start_()
+	{
+		if (states_.empty()) {
+			std::vector<uint32_t> reached;
+			for (uint32_t i = 0; i < elements_.size(); i++)
+				if (i == 0 || elements_[i - 1].kind == element_::end)
+					close_(i, reached);
+			state_of_(std::move(reached));
+		}
+		return 0;
+	}
+
+	int32_t step_(int32_t state, unsigned char c)
+	{
+		std::vector<uint32_t> reached;
+		for (auto i : *reached_[state]) {
+			const element_ &e = elements_[i];
+			if (e.kind == element_::star)
+				close_(i, reached);
+			else if (e.kind == element_::set && e.chars[c])
+				close_(i + 1, reached);
+		}
+
+		int32_t next = state_of_(std::move(reached));
+		states_[state].next[c] = next;
+		return next;
+	}
+
+public:
+	// add a pattern, the cached states are dropped
+	void add(const char *pattern)
+	{
+		for (const char *p = pattern; *p; p++) {
+			element_ e = {element_::set, {}};
+			switch (*p) {
+			case '*':
+				e.kind = element_::star;
+				break;
+
+			case '?':
+				e.chars.set();
+				break;
+
+			case '[': {
+				const char *c = p + 1;
+				bool negate = *c == '!' || *c == '^';
+				if (negate)
+					c++;
+				const char *close = strchr(*c == ']' ? c + 1 : c, ']');
+				if (!close) { // no class, a literal [
+					e.chars.set('[');
+					break;
+				}
+				for (; c < close; c++) {
+					unsigned char from = *c, to = *c;
+					if (c + 2 < close && c[1] == '-') {
+						to = c[2];
+						c += 2;
+					}
+					for (unsigned v = from; v <= to; v++)
+						e.chars.set(v);
+				}
+				if (negate)
+					e.chars.flip();
+				p = close;
+				break;
+			}
+
+			case '\\':
+				if (p[1])
+					p++;
+				/* fall through */
+			default:
+				e.chars.set((unsigned char) *p);
+			}
+			elements_.push_back(e);
+		}
+
+		elements_.push_back({element_::end, {}});
+		patterns_++;
+		flush_();
+	}
+
+	// whether text matches any of the patterns as a whole
+	bool matches(const char *text)
+	{
+		if (patterns_ == 0)
+			return false;
+
+		int32_t state = start_();
+		for (const char *c = text; *c; c++) {
+			int32_t next = states_[state].next[(unsigned char) *c];
+			if (next < 0) {
+				if (states_.size() >= max_states_) { // restart with an empty cache
+					std::vector<uint32_t> reached = *reached_[state];
+					flush_();
+					start_();
+					state = state_of_(std::move(reached));
+				}
+				next = step_(state, *c);
+			}
+			if (reached_[next]->empty())
+				return false; // no pattern can match anymore
+			state = next;
+		}
+		return states_[state].accepting;
+	}
+
+	bool matches(const std::string &text) { return matches(text.c_str()); }
+
+	size_t size() const { return patterns_; }
+	bool empty() const { return patterns_ == 0; }
+};
+
+/* specialised for glob-sets, each use of the option adds a pattern */
+inline arg_parser make_check_function(glob_set &x)
+{
+	return [&x](int, const char *arg, struct argp_state *) {
+		x.add(arg);
+		return 0;
+	};
+}
+
+} // namespace cxx_argp
+
+#endif // CXX_ARGP_GLOB_H__
@@ -0,0 +1,295 @@
+// Header-only, modern C++ network-types for the argument-parser based on ARGP
+//
+// Copyright (C) 2018-2019 Patrick Boettcher <p@yai.se>
+//
+// SPDX-License-Identifier: LGPL-3.0
+//
+// Version: 1.0.0
+//
+// Project website: https://github.com/pboettch/cxx_argp
+#ifndef CXX_ARGP_NET_H__
+#define CXX_ARGP_NET_H__
+
+#include "cxx_argp_parser.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cxx_argp
+{
+
+/* an IPv4- or IPv6-address, port 0 */
+class address
+{
+protected:
+	struct sockaddr_storage storage_ = {};
+
+public:
+	// from the text of an address, without port, false if invalid
+	bool assign(const char *text, size_t length)
+	{
+		char buffer[INET6_ADDRSTRLEN];
+		if (length >= sizeof(buffer))
+			return false;
+		memcpy(buffer, text, length);
+		buffer[length] = '\0';
+
+		storage_ = {};
+		auto v4 = reinterpret_cast<struct sockaddr_in *>(&storage_);
+		auto v6 = reinterpret_cast<struct sockaddr_in6 *>(&storage_);
+		if (inet_pton(AF_INET, buffer, &v4->sin_addr) == 1)
+			storage_.ss_family = AF_INET;
+		else if (inet_pton(AF_INET6, buffer, &v6->sin6_addr) == 1)
+			storage_.ss_family = AF_INET6;
+		else
+			return false;
+		return true;
+	}
+
+	int family() const { return storage_.ss_family; } //< AF_UNSPEC if not assigned
+
+	const struct sockaddr *get() const { return reinterpret_cast<const struct sockaddr *>(&storage_); }
+
+	// size of the sockaddr, e.g. for bind() and connect()
+	socklen_t size() const
+	{
+		return family() == AF_INET ? sizeof(struct sockaddr_in) :
+		       family() == AF_INET6 ? sizeof(struct sockaddr_in6) : 0;
+	}
+
+	// address without port as text
+	std::string str() const
+	{
+		char buffer[INET6_ADDRSTRLEN] = "";
+		if (family() == AF_INET)
+			inet_ntop(AF_INET, &reinterpret_cast<const struct sockaddr_in *>(&storage_)->sin_addr,
+			          buffer, sizeof(buffer));
+		else if (family() == AF_INET6)
+			inet_ntop(AF_INET6, &reinterpret_cast<const struct sockaddr_in6 *>(&storage_)->sin6_addr,
+			          buffer, sizeof(buffer));
+		return buffer;
+	}
+};
+
+/* an address with port: 192.0.2.1:80 or [2001:db8::1]:443 */
+class endpoint : public address
+{
+public:
+	// from the text of an endpoint, false if invalid
+	bool assign(const char *text)
+	{
+		const char *port;
+		bool ok;
+		if (text[0] == '[') { // IPv6 in brackets
+			const char *close = strchr(text, ']');
+			ok = close && close[1] == ':' && address::assign(text + 1, close - text - 1);
+			port = close ? close + 2 : nullptr;
+		} else {
+			const char *colon = strchr(text, ':');
+			ok = colon && !strchr(colon + 1, ':') && address::assign(text, colon - text);
+			port = colon ? colon + 1 : nullptr;
+		}
+		if (!ok || !isdigit(*port))
+			return false;
+
+		char *end;
+		errno = 0;
+		unsigned long number = strtoul(port, &end, 10);
+		if (*end != '\0' || errno != 0 || number > 65535)
+			return false;
+
+		// sin_port and sin6_port are at the same place
+		reinterpret_cast<struct sockaddr_in *>(&storage_)->sin_port = htons(number);
+		return true;
+	}
+
+	uint16_t port() const { return ntohs(reinterpret_cast<const struct sockaddr_in *>(&storage_)->sin_port); }
+};
+
+/* set of IPv4- and IPv6-networks given in CIDR-notation, kept as sorted,
+ * merged tables of address-intervals, searched binary */
+class cidr_list
+{
+	using uint128_ = unsigned __int128;
+
+	std::vector<std::pair<uint32_t, uint32_t>> v4_; //< first and last address, host order
+	std::vector<std::pair<uint128_, uint128_>> v6_;
+
+	template <typename T>
+	static void merge_(std::vector<std::pair<T, T>> &table)
+	{
+		std::sort(table.begin(), table.end());
+
+		size_t out = 0;
+		for (size_t i = 1; i < table.size(); i++) {
+			auto &last = table[out];
+			if (last.second == T(~T(0)) || table[i].first <= last.second + 1)
+				last.second = std::max(last.second, table[i].second);
+			else
+				table[++out] = table[i];
+		}
+		if (!table.empty())
+			table.resize(out + 1);
+	}
+
+	template <typename T>
+	static bool contains_(const std::vector<std::pair<T, T>> &table, T value)
+	{
+		auto next = std::upper_bound(table.begin(), table.end(), value,
+		                             [](T v, const std::pair<T, T> &range) { return v < range.first; });
+		return next != table.begin() && value <= (next - 1)->second;
+	}
+
+	static uint128_ v6_value_(const struct in6_addr &addr)
+	{
+		uint128_ value = 0;
+		for (auto byte : addr.s6_addr)
+			value = (value << 8) | byte;
+		return value;
+	}
+
+public:
+	// add a network, an address without /prefix is a single host; host-bits
+	// are ignored. The tables are merged when the list is done, see add_list()
+	bool add(const char *text, size_t length)
+	{
+		const char *slash = static_cast<const char *>(memchr(text, '/', length));
+
+		address a;
+		if (!a.assign(text, slash ? slash - text : length))
+			return false;
+
+		unsigned bits = a.family() == AF_INET ? 32 : 128;
+		unsigned prefix = bits;
+		if (slash) {
+			const char *end = text + length;
+			if (slash + 1 == end || end - slash > 4)
+				return false;
+			prefix = 0;
+			for (const char *c = slash + 1; c < end; c++) {
+				if (!isdigit(*c))
+					return false;
+				prefix = prefix * 10 + (*c - '0');
+			}
+			if (prefix > bits)
+				return false;
+		}
+
+		if (a.family() == AF_INET) {
+			uint32_t value = ntohl(reinterpret_cast<const struct sockaddr_in *>(a.get())->sin_addr.s_addr);
+			uint32_t host = prefix == 0 ? ~uint32_t(0) : (uint32_t(1) << (32 - prefix)) - 1;
+			v4_.push_back({value & ~host, value | host});
+		} else {
+			uint128_ value = v6_value_(reinterpret_cast<const struct sockaddr_in6 *>(a.get())->sin6_addr);
+			uint128_ host = prefix == 0 ? ~uint128_(0) : (uint128_(1) << (128 - prefix)) - 1;
+			v6_.push_back({value & ~host, value | host});
+		}
+		return true;
+	}
+
+	// add a comma-separated list of networks and merge the tables, on error
+	// the position of the invalid network is returned in error
+	bool add_list(const char *text, const char **error = nullptr)
+	{
+		bool ok = true;
+		for (const char *begin = text; ; begin++) {
+			const char *end = strchrnul(begin, ',');
+			if (!add(begin, end - begin)) {
+				if (error)
+					*error = begin;
+				ok = false;
+				break;
+			}
+			if (*end == '\0')
+				break;
+			begin = end;
+		}
+
+		merge_(v4_);
+		merge_(v6_);
+		return ok;
+	}
+
+	// IPv4-address in network byte order
+	bool contains(const struct in_addr &addr) const
+	{
+		return contains_(v4_, uint32_t(ntohl(addr.s_addr)));
+	}
+
+	// IPv6-address, IPv4-mapped ones (::ffff:a.b.c.d) are looked up as IPv4
+	bool contains(const struct in6_addr &addr) const
+	{
+		if (IN6_IS_ADDR_V4MAPPED(&addr)) {
+			struct in_addr v4;
+			memcpy(&v4, &addr.s6_addr[12], sizeof(v4));
+			return contains(v4);
+		}
+		return contains_(v6_, v6_value_(addr));
+	}
+
+	// e.g. the peer-address from accept()
+	bool contains(const struct sockaddr *addr) const
+	{
+		if (addr->sa_family == AF_INET)
+			return contains(reinterpret_cast<const struct sockaddr_in *>(addr)->sin_addr);
+		if (addr->sa_family == AF_INET6)
+			return contains(reinterpret_cast<const struct sockaddr_in6 *>(addr)->sin6_addr);
+		return false;
+	}
+
+	bool contains(const address &a) const { return contains(a.get()); }
+
+	bool empty() const { return v4_.empty() && v6_.empty(); }
+
+	// number of disjoint intervals after merging
+	size_t size() const { return v4_.size() + v6_.size(); }
+};
+
+/* specialised for addresses */
+inline arg_parser make_check_function(address &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		if (x.assign(arg, strlen(arg)))
+			return 0;
+		argp_error(state, "'%s' is not an IP-address", arg);
+		return EINVAL;
+	};
+}
+
+/* specialised for endpoints */
+inline arg_parser make_check_function(endpoint &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		if (x.assign(arg))
+			return 0;
+		argp_error(state, "'%s' is not an IP-address with port", arg);
+		return EINVAL;
+	};
+}
+
+/* for comma-separated CIDR-lists, the option can be repeated */
+inline arg_parser make_check_function(cidr_list &x)
+{
+	return [&x](int, const char *arg, struct argp_state *state) {
+		const char *invalid;
+		if (x.add_list(arg, &invalid))
+			return 0;
+		argp_error(state, "'%.*s' is not a network in CIDR-notation",
+		           (int) (strchrnul(invalid, ',') - invalid), invalid);
+		return EINVAL;
+	};
+}
+
+} // namespace cxx_argp
+
+#endif // CXX_ARGP_NET_H__
@@ -11,70 +11,333 @@
 #define CXX_ARGP_PARSER_H__
 
 #include <argp.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
 #include <cctype>
-#include <exception>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <functional>
+#include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
 namespace cxx_argp
 {
 	using arg_parser = std::function<error_t(int key, const char *, struct argp_state *state)>;
 
+	/* attributes of an option, given to parser::add_option() */
+	enum attribute : unsigned {
+		expensive = 1 << 0, //< converted after the argv-scan, concurrently with others
+		prefetch = 1 << 1,  //< argument is an input file to be read ahead into the page-cache
+		finalize = 1 << 2,  //< conversion-function is called with ARGP_KEY_END after the argv-scan
+		restart = 1 << 3,   //< conversion-function is called with ARGP_KEY_INIT before each parse
+	};
+
+	/* attributes an option always has because of the type of its variable,
+	 * overloaded for types which need them */
+	inline unsigned option_attributes(const void *) { return 0; }
+
+	/* start reading a regular file into the page-cache, returns immediately */
+	inline void prefetch_file(const char *filename)
+	{
+		int fd = open(filename, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+		if (fd < 0)
+			return; // reported by whoever opens it
+
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+			posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+		close(fd);
+	}
+
+	/* calls record for each non-empty record read from fd, records are
+	 * terminated by delimiter; a regular file is mapped, anything else is
+	 * read in large blocks. Reading stops when record returns false or, while
+	 * waiting for input, when interrupt_fd becomes readable (EINTR is
+	 * returned then), returns 0 or the errno of the failed read */
+	inline int read_records(int fd, char delimiter,
+	                        const std::function<bool(const char *)> &record,
+	                        int interrupt_fd = -1)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+			off_t offset = lseek(fd, 0, SEEK_CUR);
+			void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (offset >= 0 && map != MAP_FAILED) {
+				madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+				const char *begin = static_cast<const char *>(map) + offset;
+				const char *end = static_cast<const char *>(map) + st.st_size;
+
+				std::string value; // records in the mapping are not NUL-terminated
+				while (begin < end) {
+					auto next = static_cast<const char *>(memchr(begin, delimiter, end - begin));
+					if (!next)
+						next = end;
+					if (next != begin) {
+						value.assign(begin, next);
+						if (!record(value.c_str()))
+							break;
+					}
+					begin = next + 1;
+				}
+
+				lseek(fd, std::min<off_t>(begin - static_cast<const char *>(map), st.st_size), SEEK_SET);
+				munmap(map, st.st_size);
+				return 0;
+			}
+			if (map != MAP_FAILED)
+				munmap(map, st.st_size);
+		}
+
+		// records are terminated in place in the buffer
+		std::vector<char> buffer(1 << 20);
+		size_t begin = 0, end = 0;
+
+		for (;;) {
+			if (end == buffer.size()) {
+				if (begin > 0) {
+					memmove(buffer.data(), buffer.data() + begin, end - begin);
+					end -= begin;
+					begin = 0;
+				} else {
+					buffer.resize(buffer.size() * 2); // record longer than the buffer
+				}
+			}
+
+			if (interrupt_fd >= 0) {
+				struct pollfd fds[2] = {{fd, POLLIN, 0}, {interrupt_fd, POLLIN, 0}};
+				if (poll(fds, 2, -1) < 0) {
+					if (errno == EINTR)
+						continue;
+					return errno;
+				}
+				if (fds[1].revents)
+					return EINTR;
+			}
+
+			ssize_t n = read(fd, buffer.data() + end, buffer.size() - end);
+			if (n < 0) {
+				if (errno == EINTR)
+					continue;
+				return errno;
+			}
+			if (n == 0)
+				break;
+
+			size_t scan = end;
+			end += n;
+
+			char *next;
+			while ((next = static_cast<char *>(memchr(buffer.data() + scan, delimiter, end - scan)))) {
+				*next = '\0';
+				size_t length = next - (buffer.data() + begin);
+				if (length > 0 && !record(buffer.data() + begin))
+					return 0;
+				begin = scan = next - buffer.data() + 1;
+			}
+		}
+
+		if (begin < end) { // last record without delimiter
+			if (end == buffer.size())
+				buffer.push_back('\0');
+			else
+				buffer[end] = '\0';
+			record(buffer.data() + begin);
+		}
+
+		return 0;
+	}
+
+	/* splits a command line into words like a shell does (blanks, '...',
+	 * "..." and backslash-escapes, no expansions), the words are written
+	 * NUL-terminated to arena and argv points to them, followed by a nullptr.
+	 * Both are reused, no allocation happens once they are large enough.
+	 * Returns false for an unterminated quote or a trailing backslash */
+	inline bool split_command_line(const char *line, size_t length,
+	                               std::vector<char> &arena, std::vector<char *> &argv)
+	{
+		argv.clear();
+		arena.resize(length + 1); // words are never longer than the line
+
+		const char *in = line, *end = line + length;
+		char *out = arena.data();
+
+		for (;;) {
+			while (in < end && (*in == ' ' || *in == '\t' || *in == '\n'))
+				in++;
+			if (in == end)
+				break;
+
+			argv.push_back(out);
+			while (in < end && *in != ' ' && *in != '\t' && *in != '\n') {
+				char c = *in++;
+				if (c == '\'') {
+					auto quote = static_cast<const char *>(memchr(in, '\'', end - in));
+					if (!quote)
+						return false;
+					memcpy(out, in, quote - in);
+					out += quote - in;
+					in = quote + 1;
+				} else if (c == '"') {
+					for (;;) {
+						if (in == end)
+							return false;
+						c = *in++;
+						if (c == '"')
+							break;
+						// only these are escaped inside double quotes
+						if (c == '\\' && in < end && strchr("\"\\$`\n", *in))
+							c = *in++;
+						*out++ = c;
+					}
+				} else if (c == '\\') {
+					if (in == end)
+						return false;
+					*out++ = *in++;
+				} else {
+					*out++ = c;
+				}
+			}
+			*out++ = '\0';
+		}
+
+		argv.push_back(nullptr);
+		return true;
+	}
+
+	/* arg as a whole number in the range of T, end and errno as strtol() */
+	template <typename T>
+	inline typename std::enable_if<std::is_signed<T>::value, T>::type
+	parse_integer(const char *arg, char **end)
+	{
+		errno = 0;
+		long long value = strtoll(arg, end, 10);
+		if (errno == 0 && (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()))
+			errno = ERANGE;
+		return T(value);
+	}
+
+	template <typename T>
+	inline typename std::enable_if<std::is_unsigned<T>::value, T>::type
+	parse_integer(const char *arg, char **end)
+	{
+		errno = 0;
+		unsigned long long value = strtoull(arg, end, 10);
+
+		const char *sign = arg; // strtoull() negates a negative value
+		while (isspace(*sign))
+			sign++;
+		if (errno == 0 && (*sign == '-' || value > std::numeric_limits<T>::max()))
+			errno = ERANGE;
+		return T(value);
+	}
+
+	/* converts arg into x directly, without a conversion-function - the
+	 * built-in conversions of floating-point types, integers and std::strings,
+	 * on error argp_error() is called and EINVAL returned */
+	template <typename T>
+	inline typename std::enable_if<std::is_floating_point<T>::value, error_t>::type
+	convert_value(T &x, const char *arg, struct argp_state *state)
+	{
+		char *end;
+		errno = 0;
+		double value = strtod(arg, &end);
+		if (errno == 0 && std::isfinite(value) && std::fabs(value) > std::numeric_limits<T>::max())
+			errno = ERANGE;
+		if (end == arg || errno != 0) {
+			argp_error(
+				state, "unable to interpret '%s' as a decimal, %s",
+				arg, errno != 0 ? strerror(errno) : "no digits");
+			return EINVAL;
+		}
+		if (*end != '\0') {
+			argp_error(
+				state, "trailing characters after decimal in '%s'",
+				arg);
+			return EINVAL;
+		}
+		x = value;
+		return 0;
+	}
+
+	template <typename T>
+	inline typename std::enable_if<std::numeric_limits<T>::is_integer &&
+	                               !std::is_same<T, bool>::value, error_t>::type
+	convert_value(T &x, const char *arg, struct argp_state *state)
+	{
+		char *end;
+		T value = parse_integer<T>(arg, &end);
+		if (end == arg || errno != 0) {
+			argp_error(
+				state, "unable to interpret '%s' as a whole number, %s",
+				arg, errno != 0 ? strerror(errno) : "no digits");
+			return EINVAL;
+		}
+		if (*end != '\0') {
+			argp_error(
+				state, "trailing characters after number in '%s'",
+				arg);
+			return EINVAL;
+		}
+		x = value;
+		return 0;
+	}
+
+	inline error_t convert_value(std::string &x, const char *arg, struct argp_state *)
+	{
+		x = arg;
+		return 0;
+	}
+
 	/* for floating-point types */
 	template <typename T>
 	typename std::enable_if<std::is_floating_point<T>::value, arg_parser>::type
 	make_check_function(T &x)
 	{
 		return [&x](int, const char *arg, struct argp_state* state) {
-			try {
-				size_t end;
-				x = std::stod(arg, &end);
-				if (arg[end] != '\0') {
-					argp_error(
-						state, "trailing characters after decimal in '%s'",
-						arg);
-				}
-			} catch(std::exception &err) {
-				argp_error(
-					state, "unable to interpret '%s' as a decimal, %s",
-					arg, err.what());
-			}
-			return 0;
+			return convert_value(x, arg, state);
 		};
 	}
 
-	/* for integers */
+	/* for integers, values beyond the range of T are rejected */
 	template <typename T>
 	typename std::enable_if<std::numeric_limits<T>::is_integer, arg_parser>::type
 	make_check_function(T &x)
 	{
 		return [&x](int, const char *arg, struct argp_state* state) {
-			try {
-				size_t end;
-				x = std::stol(arg, &end);
-				if (arg[end] != '\0') {
-					argp_error(
-						state, "trailing characters after number in '%s'",
-						arg);
-				}
-			} catch(std::exception &err) {
-				argp_error(
-					state, "unable to interpret '%s' as a whole number, %s",
-					arg, err.what());
-			}
-			return 0;
+			return convert_value(x, arg, state);
 		};
 	}
 
 	/* specialised for std::strings */
 	inline arg_parser make_check_function(std::string &x)
 	{
-		return [&x](int, const char *arg, struct argp_state*) { x = arg; return 0; };
+		return [&x](int, const char *arg, struct argp_state* state) { return convert_value(x, arg, state); };
 	}
 
 	/* specialised for file-streams */
@@ -128,22 +391,482 @@ namespace cxx_argp
 		return [&x](int, const char *, struct argp_state*) { x = true; return 0; };
 	}
 
+	/* name of a keyword-option's value, tables of them are meant to be
+	 * static constexpr: {{"fast", mode::fast}, {"safe", mode::safe}} */
+	template <typename T>
+	struct keyword
+	{
+		const char *name;
+		size_t length;
+		T value;
+
+		template <size_t L>
+		constexpr keyword(const char (&name)[L], T value)
+		    : name(name), length(L - 1), value(value)
+		{}
+	};
+
+	/* for values chosen by keyword from table, which has to outlive the parser;
+	 * the lengths are compared before the names */
+	template <typename T, size_t N>
+	inline arg_parser make_check_function(T &x, const keyword<T> (&table)[N])
+	{
+		return [&x, &table](int, const char *arg, struct argp_state *state) {
+			size_t length = strlen(arg);
+			for (auto &entry : table)
+				if (entry.length == length && memcmp(entry.name, arg, length) == 0) {
+					x = entry.value;
+					return 0;
+				}
+
+			std::string names;
+			for (auto &entry : table)
+				names += std::string(names.empty() ? "" : ", ") + entry.name;
+			argp_error(state, "'%s' is not one of %s", arg, names.c_str());
+			return EINVAL;
+		};
+	}
+
+	/* name of a bit of a feature-flag set, tables of them are meant to be
+	 * static constexpr: {{"compress", 0}, {"checksum", 1}} */
+	struct flag
+	{
+		const char *name;
+		size_t length;
+		size_t bit;
+
+		template <size_t L>
+		constexpr flag(const char (&name)[L], size_t bit)
+		    : name(name), length(L - 1), bit(bit)
+		{}
+	};
+
+	/* whether all bits of table are below bits, for checking a table at
+	 * compile-time: static_assert(cxx_argp::flags_fit(table, 8), "...") */
+	template <size_t N>
+	constexpr bool flags_fit(const flag (&table)[N], size_t bits, size_t i = 0)
+	{
+		return i == N || (table[i].bit < bits && flags_fit(table, bits, i + 1));
+	}
+
+	/* calls set(bit, on) for each name of a comma-separated list, a name
+	 * prefixed with '-' is removed from the set, one with '+' or none added;
+	 * a table with a bit not below bits is an error */
+	template <size_t N, typename F>
+	inline error_t set_flags(const char *arg, const flag (&table)[N], size_t bits,
+	                         struct argp_state *state, F &&set)
+	{
+		for (auto &entry : table)
+			if (entry.bit >= bits) {
+				argp_error(state, "bit %zu of '%s' is beyond the %zu bits of the flags",
+				           entry.bit, entry.name, bits);
+				return EINVAL;
+			}
+
+		for (const char *begin = arg; ; ) {
+			const char *end = strchrnul(begin, ',');
+
+			bool on = true;
+			const char *name = begin;
+			if (*name == '-' || *name == '+')
+				on = *name++ == '+';
+			size_t length = end - name;
+
+			const flag *found = nullptr;
+			for (auto &entry : table)
+				if (entry.length == length && memcmp(entry.name, name, length) == 0) {
+					found = &entry;
+					break;
+				}
+
+			if (!found) {
+				std::string names;
+				for (auto &entry : table)
+					names += std::string(names.empty() ? "" : ", ") + entry.name;
+				argp_error(state, "'%.*s' is not one of %s", (int) length, name, names.c_str());
+				return EINVAL;
+			}
+			set(found->bit, on);
+
+			if (*end == '\0')
+				return 0;
+			begin = end + 1;
+		}
+	}
+
+	/* for feature-flags into a bitset, the option can be repeated */
+	template <size_t B, size_t N>
+	inline arg_parser make_check_function(std::bitset<B> &x, const flag (&table)[N])
+	{
+		return [&x, &table](int, const char *arg, struct argp_state *state) {
+			return set_flags(arg, table, B, state, [&x](size_t bit, bool on) {
+				x[bit] = on;
+			});
+		};
+	}
+
+	/* for feature-flags into an integral mask, the option can be repeated;
+	 * the sign-bit of a signed mask is not available */
+	template <typename T, size_t N>
+	inline typename std::enable_if<std::is_integral<T>::value, arg_parser>::type
+	make_check_function(T &x, const flag (&table)[N])
+	{
+		return [&x, &table](int, const char *arg, struct argp_state *state) {
+			return set_flags(arg, table, std::numeric_limits<T>::digits, state, [&x](size_t bit, bool on) {
+				if (on)
+					x |= T(1) << bit;
+				else
+					x &= ~(T(1) << bit);
+			});
+		};
+	}
+
+	/* calls a conversion-function outside of argp_parse, what argp_error() would
+	 * print is returned in message instead, state is used for the program-name
+	 * and flags if given */
+	inline error_t convert_silently(const arg_parser &convert, int key, const char *arg,
+	                                std::string &message,
+	                                const struct argp_state *state = nullptr)
+	{
+		static const struct argp no_argp = {};
+
+		struct argp_state silent = {};
+		if (state) {
+			silent = *state;
+		} else {
+			silent.root_argp = &no_argp;
+			silent.name = program_invocation_short_name;
+		}
+		silent.flags |= ARGP_NO_EXIT;
+
+		char *buffer = nullptr;
+		size_t size = 0;
+		silent.err_stream = open_memstream(&buffer, &size);
+
+		error_t ret = convert(key, arg, &silent);
+
+		fclose(silent.err_stream);
+		message.assign(buffer, size);
+		free(buffer);
+
+		return ret == 0 && !message.empty() ? EINVAL : ret;
+	}
+
+	/* cheap checks of an argument for a lazy value, done while parsing */
+	inline error_t lazy_check(const void *, int, const char *, struct argp_state *)
+	{
+		return 0;
+	}
+
+	/* file-streams: the file has to be readable */
+	inline error_t lazy_check(const std::ifstream *, int, const char *arg, struct argp_state *state)
+	{
+		if (access(arg, R_OK) == 0)
+			return 0;
+		argp_error(state, "unable to open '%s'", arg);
+		return -1;
+	}
+
+	template <typename T>
+	inline error_t lazy_check(const std::pair<T, std::string> *, int, const char *arg,
+	                          struct argp_state *state)
+	{
+		if (!std::is_base_of<std::istream, T>::value || access(arg, R_OK) == 0)
+			return 0;
+		argp_error(state, "unable to open '%s'", arg);
+		return -1;
+	}
+
+	/* integers and lists of them: only digits and signs */
+	inline error_t lazy_check_number_(const char *arg, const char *separators,
+	                                  struct argp_state *state)
+	{
+		for (const char *c = arg; *c; c++) {
+			if (!std::isdigit(*c) && !std::isspace(*c) && *c != '-' && *c != '+' &&
+			    !strchr(separators, *c)) {
+				argp_error(state, "unable to interpret '%s' as a whole number", arg);
+				return EINVAL;
+			}
+		}
+		return 0;
+	}
+
+	template <typename T>
+	inline typename std::enable_if<std::numeric_limits<T>::is_integer, error_t>::type
+	lazy_check(const T *, int, const char *arg, struct argp_state *state)
+	{
+		return lazy_check_number_(arg, "", state);
+	}
+
+	template <typename T>
+	inline typename std::enable_if<std::numeric_limits<T>::is_integer, error_t>::type
+	lazy_check(const std::vector<T> *, int, const char *arg, struct argp_state *state)
+	{
+		return lazy_check_number_(arg, ",", state);
+	}
+
+	/* a value which is only checked while parsing and converted on first
+	 * access, conversion is thread-safe */
+	template <typename T>
+	class lazy
+	{
+		mutable T value_;
+		mutable std::mutex mutex_;
+		mutable std::atomic<bool> converted_;
+		mutable std::string error_;
+
+		// the value before any conversion, kept to convert from a copy of it;
+		// types which cannot be copied start from T()
+		struct no_initial_ {};
+		using initial_type_ = typename std::conditional<std::is_copy_assignable<T>::value,
+		                                                T, no_initial_>::type;
+		initial_type_ initial_;
+
+		static initial_type_ initial_of_(const T &value, std::true_type) { return value; }
+		static initial_type_ initial_of_(const T &, std::false_type) { return {}; }
+		static void reset_(T &value, const T &initial) { value = initial; }
+		static void reset_(T &value, const no_initial_ &) { value = T(); }
+
+		int key_ = 0;
+		std::vector<std::string> args_; // all arguments of the current parse, in order
+
+		void convert_() const
+		{
+			if (converted_.load(std::memory_order_acquire))
+				return;
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (converted_.load(std::memory_order_relaxed))
+				return;
+
+			reset_(value_, initial_); // all arguments are converted again
+			auto convert = make_check_function(value_);
+			for (auto &arg : args_)
+				if (convert_silently(convert, key_, arg.c_str(), error_) != 0)
+					break;
+
+			converted_.store(true, std::memory_order_release);
+		}
+
+	public:
+		lazy(T value = T())
+		    : value_(std::move(value)), converted_{true},
+		      initial_(initial_of_(value_, std::is_copy_assignable<T>())) {}
+
+		// sets an argument to be converted on first access
+		void assign(int key, const char *arg)
+		{
+			key_ = key;
+			args_.push_back(arg);
+			error_.clear();
+			converted_ = false;
+		}
+
+		// forget the arguments of a previous parse, back to the initial value
+		void restart()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			args_.clear();
+			error_.clear();
+			reset_(value_, initial_);
+			converted_ = true;
+		}
+
+		// whether the option was given at all
+		bool given() const { return !args_.empty(); }
+		// whether the conversion has been done
+		bool converted() const { return converted_; }
+
+		T &get() { convert_(); return value_; }
+		const T &get() const { convert_(); return value_; }
+
+		T &operator*() { return get(); }
+		const T &operator*() const { return get(); }
+		T *operator->() { return &get(); }
+		const T *operator->() const { return &get(); }
+
+		// argp's error-message if conversion failed, empty otherwise
+		const std::string &error() const { convert_(); return error_; }
+	};
+
+	/* lazy values start over with each parse */
+	template <typename T>
+	inline unsigned option_attributes(const lazy<T> *) { return restart; }
+
+	/* specialised for lazy values */
+	template <typename T>
+	inline arg_parser make_check_function(lazy<T> &x)
+	{
+		return [&x](int key, const char *arg, struct argp_state *state) {
+			if (key == ARGP_KEY_INIT) {
+				x.restart();
+				return 0;
+			}
+			error_t ret = lazy_check(static_cast<const T *>(nullptr), key, arg, state);
+			if (ret == 0)
+				x.assign(key, arg);
+			return ret;
+		};
+	}
+
+	/* bounded queue of positional arguments, filled by the parser and
+	 * consumed by another thread while parsing continues */
+	class argument_queue
+	{
+		std::deque<std::string> queue_;
+		size_t capacity_;
+		bool closed_ = false;
+
+		std::mutex mutex_;
+		std::condition_variable not_empty_, not_full_;
+
+	public:
+		explicit argument_queue(size_t capacity = 1024) : capacity_(capacity) {}
+
+		// blocks while the queue is full
+		void push(const char *arg)
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_full_.wait(lock, [this] { return queue_.size() < capacity_; });
+			queue_.push_back(arg);
+			not_empty_.notify_one();
+		}
+
+		// no more arguments will be pushed
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			closed_ = true;
+			not_empty_.notify_all();
+		}
+
+		// blocks until an argument is available, false when closed and empty
+		bool pop(std::string &arg)
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_empty_.wait(lock, [this] { return !queue_.empty() || closed_; });
+			if (queue_.empty())
+				return false;
+
+			arg = std::move(queue_.front());
+			queue_.pop_front();
+			not_full_.notify_one();
+			return true;
+		}
+	};
+
+	/* an argp-option with its conversion-function and attributes, for
+	 * registering many options at once with parser::add_options() */
+	struct option_binding
+	{
+		argp_option option;
+		arg_parser convert;
+		unsigned attributes;
+
+		template <typename T>
+		option_binding(const argp_option &option, T &var, unsigned attributes = 0)
+		    : option(option), convert(make_check_function(var)),
+		      attributes(attributes | option_attributes(&var))
+		{}
+
+		option_binding(const argp_option &option, arg_parser &&convert, unsigned attributes = 0)
+		    : option(option), convert(std::move(convert)), attributes(attributes)
+		{}
+	};
+
 class parser
 {
 	//< argp-option-vector
 	std::vector<argp_option> options_ = {{}};
 
-	//< conversion-function - from const char *arg to value
-	std::map<int, arg_parser> convert_;
+	//< conversion-function - from const char *arg to value - and attributes
+	struct binding_
+	{
+		arg_parser convert;
+		unsigned attributes;
+	};
+	std::map<int, binding_> convert_;
+
+	//< conversions of expensive options deferred to the end of argp_parse
+	struct deferred_conversion_
+	{
+		const arg_parser *convert;
+		int key;
+		const char *arg;
+	};
+	std::vector<deferred_conversion_> deferred_;
+
+	//< conversion-functions to be called at the end of the argv-scan
+	std::vector<const arg_parser *> finalizers_;
+
+	//< conversion-functions to be called before each parse
+	std::vector<const arg_parser *> restarters_;
 
 	//< expected positional argument count (-1, unlimited)
 	ssize_t expected_argument_count_ = 0;
 
-	//< positional arguments
+	//< positional arguments and their attributes
 	std::vector<std::string> arguments_;
+	unsigned argument_attributes_ = 0;
+
+	//< positional argument count, also when not stored in arguments_
+	size_t argument_count_ = 0;
+
+	//< called for each positional argument instead of storing it
+	std::function<bool(const char *)> argument_callback_;
+	argument_queue *argument_queue_ = nullptr;
+
+	//< typed positional arguments converted in order, a repeated slot takes
+	//< all remaining arguments (deque: finalizers_ point into it)
+	struct slot_
+	{
+		arg_parser convert;
+		bool repeated;
+	};
+	std::deque<slot_> slots_;
+
+	//< positional arguments are also read from stdin, delimited by stdin_delimiter_
+	static const int args_from_stdin_key_ = 0x10000;
+	bool stdin_arguments_ = false;
+	bool stdin_requested_ = false;
+	char stdin_delimiter_ = '\n';
 
 	unsigned flags_ = 0;
 
+	//< argp's help or usage was requested in the last parsed command line
+	bool help_shown_ = false;
+
+	//< words and argv of the last command line parsed from a string
+	std::vector<char> cmdline_arena_;
+	std::vector<char *> cmdline_argv_;
+
+	//< sub-command: its options are only added to a parser when it is invoked
+	struct subcommand_
+	{
+		const char *doc;
+		std::function<void(parser &)> build;
+		ssize_t expected_argument_count;
+	};
+
+	//< registered sub-commands by name
+	std::map<std::string, subcommand_> subcommands_;
+
+	//< name and parser of the invoked sub-command
+	std::string subcommand_name_;
+	std::unique_ptr<parser> subparser_;
+
+	//< parser holding the common options (set for sub-command-parsers)
+	parser *common_ = nullptr;
+
+	//< candidate values for the completion of option-arguments
+	std::map<int, std::vector<std::string>> completions_;
+
+	//< generated option-docs (deque: options_ point to them)
+	std::deque<std::string> docs_;
+
+	//< lazily provided option-groups: header and function adding the options
+	std::vector<std::pair<const char *, std::function<void(parser &)>>> providers_;
+	size_t provided_ = 0;
 
 	//! argp-callback
 	static error_t parseoptions_cb_(int key, char *arg, struct argp_state *state)
@@ -152,35 +875,589 @@ class parser
 			->parseoptions_(key, arg, state);
 	}
 
+	//! argp-callback for the common options used as child of a sub-command
+	static error_t common_options_cb_(int key, char *arg, struct argp_state *state)
+	{
+		auto common = reinterpret_cast<cxx_argp::parser *>(state->input);
+		if (key == ARGP_KEY_INIT)
+			return common->restart_(state);
+		if (key == ARGP_KEY_END)
+			return common->finalize_(state);
+
+		auto option = common->convert_.find(key);
+		if (option == common->convert_.end())
+			return ARGP_ERR_UNKNOWN;
+		return common->subparser_->convert_option_(option->second, key, arg, state);
+	}
+
+	// convert an option's argument now, or later if it is expensive
+	error_t convert_option_(const binding_ &binding, int key, const char *arg,
+	                        struct argp_state *state)
+	{
+		if (arg && (binding.attributes & prefetch))
+			prefetch_file(arg);
+
+		if (binding.attributes & expensive) {
+			deferred_.push_back({&binding.convert, key, arg});
+			return 0;
+		}
+		return binding.convert(key, arg, state);
+	}
+
+	// let conversion-functions know that a parse starts
+	error_t restart_(struct argp_state *state)
+	{
+		for (auto convert : restarters_) {
+			error_t ret = (*convert)(ARGP_KEY_INIT, nullptr, state);
+			if (ret != 0)
+				return ret;
+		}
+		return 0;
+	}
+
+	// let conversion-functions know that all arguments have been seen
+	error_t finalize_(struct argp_state *state)
+	{
+		for (auto convert : finalizers_) {
+			error_t ret = (*convert)(ARGP_KEY_END, nullptr, state);
+			if (ret != 0)
+				return ret;
+		}
+		return 0;
+	}
+
+	// run the deferred conversions on a small pool of threads, conversions
+	// of the same option are done in order by the same thread. Errors are
+	// reported afterwards in argument order as argp_error() would have.
+	error_t convert_deferred_(struct argp_state *state)
+	{
+		if (deferred_.empty())
+			return 0;
+
+		// tasks: indices into deferred_ sharing a conversion-function
+		std::vector<std::vector<size_t>> tasks;
+		for (size_t i = 0; i < deferred_.size(); i++) {
+			auto task = tasks.begin();
+			while (task != tasks.end() && deferred_[task->front()].convert != deferred_[i].convert)
+				++task;
+			if (task == tasks.end())
+				tasks.push_back({i});
+			else
+				task->push_back(i);
+		}
+
+		std::vector<error_t> results(deferred_.size());
+		std::vector<std::string> messages(deferred_.size());
+		std::atomic<size_t> next{0};
+
+		auto work = [&]() {
+			for (size_t t; (t = next++) < tasks.size();) {
+				for (auto i : tasks[t]) {
+					auto &d = deferred_[i];
+					results[i] = convert_silently(*d.convert, d.key, d.arg, messages[i], state);
+					if (results[i] != 0)
+						break;
+				}
+			}
+		};
+
+		// hardware_concurrency() may be 0 if unknown; at most 8 threads
+		size_t concurrency = std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+		std::vector<std::thread> pool;
+		for (size_t i = 1; i < std::min(tasks.size(), concurrency); i++)
+			pool.emplace_back(work);
+		work();
+		for (auto &thread : pool)
+			thread.join();
+
+		deferred_.clear();
+
+		for (size_t i = 0; i < results.size(); i++) {
+			if (results[i] == 0)
+				continue;
+			if (!(state->flags & ARGP_NO_ERRS) && state->err_stream)
+				fputs(messages[i].c_str(), state->err_stream);
+			if (!(state->flags & ARGP_NO_EXIT))
+				exit(argp_err_exit_status);
+			return results[i];
+		}
+		return 0;
+	}
+
+	// find an option by its long name, unambiguous abbreviations are accepted,
+	// exact tells whether the name matched in full
+	const argp_option *find_option_(const char *name, size_t length, bool &exact) const
+	{
+		const argp_option *abbreviated = nullptr;
+		exact = false;
+		for (auto &option : options_) {
+			if (!option.name || strncmp(option.name, name, length) != 0)
+				continue;
+			if (option.name[length] == '\0') {
+				exact = true;
+				return &option;
+			}
+			if (!abbreviated)
+				abbreviated = &option;
+		}
+		return abbreviated;
+	}
+
+	// find an option by its short key
+	const argp_option *find_option_(int key) const
+	{
+		for (auto &option : options_)
+			if (option.key == key && std::isprint(key))
+				return &option;
+		return nullptr;
+	}
+
+	// whether the option consumes the next argv-element as its argument
+	static bool takes_argument_(const argp_option *option)
+	{
+		if (!option)
+			return false;
+		// an alias inherits the argument of the previous non-alias option
+		while (option->flags & OPTION_ALIAS)
+			option--;
+		return option->arg && !(option->flags & OPTION_ARG_OPTIONAL);
+	}
+
+	// whether name is an abbreviation of argp's built-in long option
+	static bool is_builtin_(const char *name, size_t length, const char *builtin)
+	{
+		return length > 0 && strncmp(builtin, name, length) == 0;
+	}
+
+	// whether name is argp's built-in long option in full
+	static bool is_builtin_name_(const char *name, size_t length, const char *builtin)
+	{
+		return strlen(builtin) == length && strncmp(builtin, name, length) == 0;
+	}
+
+	// add the next lazily provided option-group, own groups first
+	bool provide_next_()
+	{
+		if (provided_ < providers_.size()) {
+			auto &group = providers_[provided_++];
+			options_.insert(options_.end() - 1, {nullptr, 0, nullptr, 0, group.first});
+			group.second(*this);
+			return true;
+		}
+		return common_ && common_->provide_next_();
+	}
+
+	void provide_all_()
+	{
+		while (provide_next_())
+			;
+	}
+
+	// find an option by its long name in this and the common parser, option-groups
+	// are provided until it is found, help and usage need all of them. An
+	// abbreviation may be the full name of an option not yet provided, so
+	// all groups are provided unless the name matches exactly
+	const argp_option *lookup_option_(const char *name, size_t length)
+	{
+		for (;;) {
+			bool exact = false;
+			const argp_option *option = find_option_(name, length, exact);
+			if (!exact && common_) {
+				bool common_exact;
+				const argp_option *common = common_->find_option_(name, length, common_exact);
+				if (common_exact || !option) {
+					option = common;
+					exact = common_exact;
+				}
+			}
+			if (exact)
+				return option;
+			if (option) {
+				if (!provide_next_())
+					return option; // nothing changed, option is still valid
+				continue;
+			}
+
+			if (is_builtin_(name, length, "help") || is_builtin_(name, length, "usage")) {
+				if (!provide_next_())
+					return nullptr;
+				provide_all_(); // and look again, it may abbreviate one of them
+				continue;
+			}
+			// argp's hidden options and --version, when it has one, are
+			// no abbreviations of an option which is not yet provided
+			bool version = argp_program_version || argp_program_version_hook;
+			if ((version && is_builtin_name_(name, length, "version")) ||
+			    is_builtin_name_(name, length, "program-name") ||
+			    is_builtin_name_(name, length, "HANG"))
+				return nullptr;
+
+			if (!provide_next_())
+				return nullptr;
+		}
+	}
+
+	// same for a short option
+	const argp_option *lookup_option_(int key)
+	{
+		for (;;) {
+			const argp_option *option = find_option_(key);
+			if (!option && common_)
+				option = common_->find_option_(key);
+			if (option)
+				return option;
+
+			if (key == '?') {
+				provide_all_();
+				return nullptr;
+			}
+			if (!provide_next_())
+				return nullptr;
+		}
+	}
+
+	// look at the options in argv before parsing to provide the option-groups
+	// needed and to notice argp's help, returns the index of the first
+	// positional argument (0 if none)
+	int scan_(int argc, char *argv[], bool stop_at_argument)
+	{
+		int first = 0;
+
+		for (int i = 1; i < argc; i++) {
+			const char *arg = argv[i];
+
+			if (arg[0] != '-' || arg[1] == '\0') {
+				if (!first)
+					first = i;
+				if (stop_at_argument)
+					break;
+				continue;
+			}
+
+			if (arg[1] == '-') {
+				if (arg[2] == '\0') // "--" ends options
+					return first ? first : (i + 1 < argc ? i + 1 : 0);
+
+				const char *name = arg + 2;
+				const char *value = strchr(name, '=');
+				const size_t length = value ? value - name : strlen(name);
+				auto option = lookup_option_(name, length);
+				if (!option && !(flags_ & ARGP_NO_HELP) &&
+				    (is_builtin_(name, length, "help") || is_builtin_(name, length, "usage")))
+					help_shown_ = true;
+				if (!value && takes_argument_(option))
+					i++;
+				continue;
+			}
+
+			for (const char *c = arg + 1; *c; c++) {
+				auto option = lookup_option_(*c);
+				if (!option && *c == '?' && !(flags_ & ARGP_NO_HELP))
+					help_shown_ = true;
+				if (takes_argument_(option)) {
+					if (c[1] == '\0')
+						i++;
+					break;
+				}
+			}
+		}
+		return first;
+	}
+
+	// run argp and evaluate the result
+	bool parse_(const struct argp &argp, int argc, char *argv[])
+	{
+		int ret = argp_parse(&argp, argc, argv, flags_, nullptr, this);
+
+		if (flags_ & ARGP_NO_ERRS)
+			return true;
+
+		const bool help_disabled = help_via_argp_flags && (flags_ & ARGP_NO_HELP);
+
+		if (ret != 0) {
+			if (!help_disabled)
+				argp_help(&argp, stderr, ARGP_HELP_USAGE, argv[0]);
+			return false;
+		}
+
+		// with ARGP_NO_EXIT argp returns after the help, nothing is to be run
+		if (help_shown_)
+			return false;
+
+		if ((expected_argument_count_ != -1 &&
+		     (size_t) expected_argument_count_ != argument_count_) ||
+		    argument_count_ < required_argument_count_()) {
+			if (!help_disabled)
+				argp_help(&argp, stderr, ARGP_HELP_USAGE, argv[0]);
+			return false;
+		}
+
+		return true;
+	}
+
+	// create the parser of a sub-command and add its options
+	parser &build_subcommand_(const std::pair<const std::string, subcommand_> &cmd)
+	{
+		subcommand_name_ = cmd.first;
+		subparser_.reset(new parser(cmd.second.expected_argument_count));
+		subparser_->flags_ = flags_;
+		subparser_->help_via_argp_flags = help_via_argp_flags;
+		subparser_->common_ = this;
+		cmd.second.build(*subparser_);
+		return *subparser_;
+	}
+
+	// print the completions of an option-argument registered for key
+	void complete_value_(int key, const char *prefix, const char *word, FILE *out) const
+	{
+		auto values = completions_.find(key);
+		if (values == completions_.end()) {
+			if (common_)
+				common_->complete_value_(key, prefix, word, out);
+			return;
+		}
+
+		for (auto &value : values->second)
+			if (value.compare(0, strlen(word), word) == 0)
+				fprintf(out, "%s%s\n", prefix, value.c_str());
+	}
+
+	// print the options starting with word, "-" completes short and long options
+	void complete_option_(const char *word, FILE *out) const
+	{
+		const bool all = word[1] == '\0';
+		const bool is_long = word[1] == '-';
+		const char *name = is_long ? word + 2 : "";
+		const size_t length = strlen(name);
+
+		for (auto &option : options_) {
+			if (option.flags & (OPTION_DOC | OPTION_HIDDEN))
+				continue;
+			if (std::isprint(option.key) && (all || (!is_long && word[1] == option.key && word[2] == '\0')))
+				fprintf(out, "-%c\n", option.key);
+			if (option.name && (all || is_long) && strncmp(option.name, name, length) == 0)
+				fprintf(out, "--%s\n", option.name);
+		}
+
+		if (common_) {
+			common_->complete_option_(word, out);
+			return;
+		}
+
+		// argp's own options
+		if (!all && !is_long)
+			return;
+		if (!(flags_ & ARGP_NO_HELP)) {
+			for (const char *builtin : {"help", "usage"})
+				if (strncmp(builtin, name, length) == 0)
+					fprintf(out, "--%s\n", builtin);
+		}
+		if ((argp_program_version || argp_program_version_hook) &&
+		    strncmp("version", name, length) == 0)
+			fprintf(out, "--version\n");
+	}
+
+	// build the parser of the sub-command at argv[index] and parse with it,
+	// the common options are added as argp-child without being copied
+	bool parse_subcommand_(const std::pair<const std::string, subcommand_> &cmd,
+	                       int index, int argc, char *argv[], const char *usage)
+	{
+		build_subcommand_(cmd).scan_(argc, argv, false);
+
+		// argv[0] names program and sub-command for argp's messages
+		std::string name = std::string(argv[0]) + " " + cmd.first;
+		std::vector<char *> args(argv, argv + argc);
+		args.erase(args.begin() + index);
+		args[0] = &name[0];
+
+		struct argp common = {options_.data(), parser::common_options_cb_};
+		struct argp_child children[] = {{&common, 0, "Common options:", 0}, {}};
+		struct argp argp = {subparser_->options_.data(), parser::parseoptions_cb_,
+		                    usage, cmd.second.doc, children};
+
+		bool ok = subparser_->parse_(argp, args.size(), args.data());
+		arguments_ = std::move(subparser_->arguments_);
+		argument_count_ = subparser_->argument_count_;
+		help_shown_ = help_shown_ || subparser_->help_shown_;
+		return ok;
+	}
+
+	// handle a positional argument
+	error_t argument_(const char *arg, struct argp_state *state)
+	{
+		argument_count_++;
+
+		if (argument_attributes_ & prefetch)
+			prefetch_file(arg);
+
+		if (!slots_.empty()) {
+			size_t index = argument_count_ - 1;
+			if (slots_.back().repeated)
+				index = std::min(index, slots_.size() - 1);
+			if (index < slots_.size()) // too many otherwise, reported at the end
+				return slots_[index].convert(ARGP_KEY_ARG, arg, state);
+		}
+
+		if (argument_queue_) {
+			argument_queue_->push(arg);
+		} else if (argument_callback_) {
+			if (!argument_callback_(arg)) {
+				argp_error(state, "argument '%s' not usable", arg);
+				return EINVAL;
+			}
+		} else {
+			arguments_.push_back(arg);
+		}
+		return 0;
+	}
+
+	// add an option whose argument is one of the names in table, they are
+	// appended to the doc and completed; false if the key is already used
+	template <typename E, size_t N>
+	bool add_named_option_(const argp_option &option, const E (&table)[N],
+	                       arg_parser &&convert, unsigned attributes)
+	{
+		if (key_used_(option))
+			return false;
+
+		std::string doc = option.doc ? option.doc : "";
+		std::vector<std::string> names;
+		for (auto &entry : table) {
+			doc += (names.empty() ? " (" : ", ") + std::string(entry.name);
+			names.push_back(entry.name);
+		}
+		docs_.push_back(doc + ")");
+
+		argp_option documented = option;
+		documented.doc = docs_.back().c_str();
+		bind_(documented, convert, attributes);
+		add_completion(option.key, std::move(names));
+		return true;
+	}
+
+	// add the binding of an option whose key is known to be unused, key 0
+	// (documentation and group-headers) is not bound
+	void bind_(const argp_option &option, const arg_parser &convert, unsigned attributes)
+	{
+		options_.insert(options_.end() - 1, option);
+		if (option.key == 0 || (option.flags & OPTION_ALIAS)) // an alias uses the binding of its option
+			return;
+		auto binding = convert_.emplace_hint(convert_.end(), option.key, binding_{convert, attributes});
+		if (attributes & finalize)
+			finalizers_.push_back(&binding->second.convert);
+		if (attributes & restart)
+			restarters_.push_back(&binding->second.convert);
+	}
+
+	bool key_used_(int key) const
+	{
+		return key != 0 && convert_.find(key) != convert_.end();
+	}
+
+	// an OPTION_ALIAS repeats the key of its option and is not bound itself
+	bool key_used_(const argp_option &option) const
+	{
+		return !(option.flags & OPTION_ALIAS) && key_used_(option.key);
+	}
+
+	// positional arguments needed by the typed slots
+	size_t required_argument_count_() const
+	{
+		return slots_.empty() || !slots_.back().repeated ? slots_.size() : slots_.size() - 1;
+	}
+
+	void add_argument_(arg_parser &&convert, bool finalizes, bool repeated = false)
+	{
+		if (!slots_.empty() && slots_.back().repeated)
+			return; // nothing is left for a slot after a repeated one
+
+		slots_.push_back({std::move(convert), repeated || finalizes});
+		if (finalizes)
+			finalizers_.push_back(&slots_.back().convert);
+
+		expected_argument_count_ = slots_.back().repeated ? -1 : (ssize_t) slots_.size();
+	}
+
+	// read positional arguments from stdin, once
+	error_t stdin_arguments_read_(struct argp_state *state)
+	{
+		stdin_requested_ = false;
+
+		error_t ret = 0;
+		int err = read_records(STDIN_FILENO, stdin_delimiter_, [this, state, &ret](const char *arg) {
+			ret = argument_(arg, state);
+			return ret == 0;
+		});
+		if (err != 0) {
+			argp_failure(state, argp_err_exit_status, err, "reading arguments from stdin");
+			return err;
+		}
+		return ret;
+	}
+
 protected:
 	virtual error_t parseoptions_(int key, char *arg, struct argp_state *state)
 	{
 		switch (key) {
 		case ARGP_KEY_INIT:
 			arguments_.clear();
-			break;
+			argument_count_ = 0;
+			stdin_requested_ = false;
+			deferred_.clear();
+			if (common_)
+				state->child_inputs[0] = common_;
+			return restart_(state);
 
 		case ARGP_KEY_ARG:
-			arguments_.push_back(arg);
-			break;
+			if (!subcommands_.empty()) {
+				argp_error(state, "unknown command '%s'", arg);
+				return EINVAL;
+			}
+			if (stdin_arguments_ && strcmp(arg, "-") == 0)
+				return stdin_arguments_read_(state);
+			return argument_(arg, state);
+
+		case ARGP_KEY_END: {
+			error_t ret = stdin_requested_ ? stdin_arguments_read_(state) : 0;
+			if (ret == 0)
+				ret = convert_deferred_(state);
+			if (ret == 0)
+				ret = finalize_(state);
+			if (ret != 0)
+				return ret;
 
-		case ARGP_KEY_END:
-			if (expected_argument_count_ == -1)
+			if (expected_argument_count_ == -1) {
+				if (argument_count_ < required_argument_count_())
+					argp_error(state, "too few arguments given");
 				break;
+			}
 
-			if (arguments_.size() > (size_t) expected_argument_count_)
+			if (argument_count_ > (size_t) expected_argument_count_)
 				argp_error(state, "too many arguments given");
-			else if (arguments_.size() < (size_t) expected_argument_count_)
+			else if (argument_count_ < (size_t) expected_argument_count_)
 				argp_error(state, "too few arguments given");
 			break;
+		}
 
 		case ARGP_KEY_ERROR:
 			break;
 
+		case ARGP_KEY_FINI:
+			if (argument_queue_)
+				argument_queue_->close();
+			break;
+
+		case args_from_stdin_key_:
+			if (stdin_arguments_) {
+				stdin_requested_ = true;
+				break;
+			}
+			/* fall through */
+
 		default: {
 			auto option = convert_.find(key);
 			if (option != convert_.end()) {
-				return option->second(key, arg, state);
+				return convert_option_(option->second, key, arg, state);
 			}
 		}}
 
@@ -194,25 +1471,31 @@ public:
 		expected_argument_count_(expected_argument_count),
 		help_via_argp_flags{true} {}
 
-	// add an argp-option to the options we care about
+	// add an argp-option to the options we care about, attributes are
+	// a combination of cxx_argp::attribute-values; false, and the option is
+	// not added, if its key is already used - except by an OPTION_ALIAS
+	// following its option, whose variable and conversion are not used
 	template <typename T>
-	void add_option(const argp_option &option, T &var)
+	bool add_option(const argp_option &option, T &var, unsigned attributes = 0)
 	{
-		add_option(option, make_check_function(var));
+		return add_option(option, make_check_function(var), attributes | option_attributes(&var));
 	}
 
-	void add_option(const argp_option &option,
-	                const arg_parser &&custom)
+	bool add_option(const argp_option &option,
+	                const arg_parser &&custom,
+	                unsigned attributes = 0)
 	{
-		options_.insert(options_.end() - 1, option);
-		convert_.insert({option.key, custom});
+		if (key_used_(option))
+			return false;
+		bind_(option, custom, attributes);
+		return true;
 	}
 
-	void add_option(const argp_option &option,
-	                const std::function<bool(const char *)> &&custom)
+	bool add_option(const argp_option &option,
+	                const std::function<bool(const char *)> &&custom,
+	                unsigned attributes = 0)
 	{
-		options_.insert(options_.end() - 1, option);
-		convert_.insert({option.key, [custom](int key, const char *arg, struct argp_state* state) {
+		return add_option(option, [custom](int key, const char *arg, struct argp_state* state) {
 			if (!custom(arg)) {
 				if (std::isprint(key)) {
 					argp_error(state, "argument '%s' not usable for '%c'", arg, key);
@@ -222,41 +1505,293 @@ public:
 				return -1;
 			}
 			return 0;
-		}});
+		}, attributes);
 	}
 
-	// processes arguments with argp_parse and evaluate standarda arguments
-	bool parse(int argc, char *argv[], const char *usage = "", const char *doc = nullptr)
+	// make room for count more options, before adding many of them
+	void reserve(size_t count)
 	{
-		struct argp argp = {options_.data(), parser::parseoptions_cb_, usage, doc};
+		options_.reserve(options_.size() + count);
+	}
 
-		int ret = argp_parse(&argp, argc, argv, flags_, nullptr, this);
+	// add the options of a range of option_bindings in one pass; false, and
+	// none is added, if a key is used twice or already used
+	template <typename Iterator>
+	bool add_options(Iterator first, Iterator last)
+	{
+		std::vector<int> keys;
+		for (Iterator i = first; i != last; ++i)
+			if (i->option.key != 0 && !(i->option.flags & OPTION_ALIAS))
+				keys.push_back(i->option.key);
 
-		if (flags_ & ARGP_NO_ERRS)
-			return true;
+		std::sort(keys.begin(), keys.end());
+		if (std::adjacent_find(keys.begin(), keys.end()) != keys.end())
+			return false;
+		for (auto key : keys)
+			if (key_used_(key))
+				return false;
 
-		const bool help_disabled = help_via_argp_flags && (flags_ & ARGP_NO_HELP);
+		reserve(std::distance(first, last));
+		for (Iterator i = first; i != last; ++i)
+			bind_(i->option, i->convert, i->attributes);
+		return true;
+	}
 
-		if (ret != 0) {
-			if (!help_disabled)
-				argp_help(&argp, stderr, ARGP_HELP_USAGE, argv[0]);
+	template <typename Range>
+	bool add_options(const Range &bindings)
+	{
+		return add_options(std::begin(bindings), std::end(bindings));
+	}
+
+	bool add_options(std::initializer_list<option_binding> bindings)
+	{
+		return add_options(bindings.begin(), bindings.end());
+	}
+
+	// add an option whose value is chosen by keyword from table, which has to
+	// outlive the parser; the keywords are appended to the doc and completed
+	template <typename T, size_t N>
+	bool add_option(const argp_option &option, T &var,
+	                const keyword<T> (&table)[N],
+	                unsigned attributes = 0)
+	{
+		return add_named_option_(option, table, make_check_function(var, table), attributes);
+	}
+
+	// add an option setting and clearing feature-flags by name in a bitset or
+	// an integral mask, e.g. --features=a,b,-c, table has to outlive the parser
+	template <typename T, size_t N>
+	bool add_option(const argp_option &option, T &var,
+	                const flag (&table)[N],
+	                unsigned attributes = 0)
+	{
+		return add_named_option_(option, table, make_check_function(var, table), attributes);
+	}
+
+	// add a sub-command, the options added to this parser are common to
+	// all sub-commands, build is only called when the sub-command is invoked
+	// to add its options to the (sub-)parser passed as argument
+	void add_subcommand(const char *name, const char *doc,
+	                    std::function<void(parser &)> &&build,
+	                    ssize_t expected_argument_count = 0)
+	{
+		subcommands_.insert({name, {doc, std::move(build), expected_argument_count}});
+	}
+
+	// add an option-group whose options are added by provide only when needed:
+	// when one of its options is used or when the help is printed
+	void add_option_group(const char *header, std::function<void(parser &)> &&provide)
+	{
+		providers_.push_back({header, std::move(provide)});
+	}
+
+	// candidate values printed when completing the argument of the option key
+	void add_completion(int key, std::vector<std::string> &&values)
+	{
+		completions_[key] = std::move(values);
+	}
+
+	// print the candidates for the last, partial element of argv, one per line,
+	// from the options only (no conversion-function is called)
+	void complete(int argc, char *argv[], FILE *out = stdout)
+	{
+		if (argc < 2)
+			return;
+
+		const char *word = argv[argc - 1];
+
+		if (!subcommands_.empty()) {
+			int index = scan_(argc - 1, argv, true);
+			if (index) {
+				auto cmd = subcommands_.find(argv[index]);
+				if (cmd == subcommands_.end())
+					return;
+
+				std::vector<char *> args(argv, argv + argc);
+				args.erase(args.begin() + index);
+				build_subcommand_(*cmd).complete(args.size(), args.data(), out);
+				return;
+			}
+		}
+
+		provide_all_();
+
+		for (int i = 1; i < argc - 1; i++)
+			if (strcmp(argv[i], "--") == 0)
+				word = nullptr;
+
+		if (word) {
+			// argument of the previous option
+			const char *previous = argc > 2 ? argv[argc - 2] : "";
+			const argp_option *option = nullptr;
+			if (previous[0] == '-' && previous[1] == '-') {
+				if (!strchr(previous, '='))
+					option = lookup_option_(previous + 2, strlen(previous + 2));
+			} else if (previous[0] == '-' && previous[1] != '\0') {
+				option = lookup_option_(previous[strlen(previous) - 1]);
+				if (option && !takes_argument_(option))
+					option = nullptr;
+				for (const char *c = previous + 1; option && *c && c[1]; c++)
+					if (takes_argument_(lookup_option_(*c))) // value is attached
+						option = nullptr;
+			}
+
+			if (takes_argument_(option)) {
+				complete_value_(option->key, "", word, out);
+				return;
+			}
+
+			// option with attached argument: --name=value
+			const char *value = strchr(word, '=');
+			if (word[0] == '-' && word[1] == '-' && value) {
+				std::string prefix(word, value + 1);
+				option = lookup_option_(word + 2, value - word - 2);
+				if (option)
+					complete_value_(option->key, prefix.c_str(), value + 1, out);
+				return;
+			}
+
+			if (word[0] == '-') {
+				complete_option_(word, out);
+				return;
+			}
+		} else {
+			word = argv[argc - 1];
+		}
+
+		for (auto &cmd : subcommands_)
+			if (cmd.first.compare(0, strlen(word), word) == 0)
+				fprintf(out, "%s\n", cmd.first.c_str());
+	}
+
+	// processes arguments with argp_parse and evaluate standarda arguments,
+	// prints completions instead if CXX_ARGP_COMPLETE is set in the environment
+	bool parse(int argc, char *argv[], const char *usage = "", const char *doc = nullptr)
+	{
+		subcommand_name_.clear();
+		subparser_.reset();
+		help_shown_ = false;
+
+		if (getenv("CXX_ARGP_COMPLETE")) {
+			complete(argc, argv);
+			if (!(flags_ & ARGP_NO_EXIT))
+				exit(EXIT_SUCCESS);
 			return false;
 		}
 
-		if (expected_argument_count_ != -1 &&
-		    (size_t) expected_argument_count_ != arguments_.size()) {
-			if (!help_disabled)
-				argp_help(&argp, stderr, ARGP_HELP_USAGE, argv[0]);
+		if (subcommands_.empty()) {
+			// without exiting, the scan also notices a request for the help
+			if (provided_ < providers_.size() || (flags_ & ARGP_NO_EXIT))
+				scan_(argc, argv, false);
+
+			struct argp argp = {options_.data(), parser::parseoptions_cb_, usage, doc};
+			return parse_(argp, argc, argv);
+		}
+
+		int index = scan_(argc, argv, true);
+		if (index) {
+			auto cmd = subcommands_.find(argv[index]);
+			if (cmd != subcommands_.end())
+				return parse_subcommand_(*cmd, index, argc, argv, usage);
+		}
+
+		// no (known) sub-command given, list all of them in the help
+		std::vector<argp_option> commands;
+		commands.reserve(subcommands_.size() + 1);
+		for (auto &cmd : subcommands_)
+			commands.push_back({cmd.first.c_str(), 0, nullptr, OPTION_DOC | OPTION_NO_USAGE, cmd.second.doc});
+		commands.push_back({});
+
+		struct argp commands_argp = {commands.data()};
+		struct argp_child children[] = {{&commands_argp, 0, "Commands:", 0}, {}};
+		struct argp argp = {options_.data(), parser::parseoptions_cb_, usage, doc, children};
+		return parse_(argp, argc, argv);
+	}
+
+	// parse a command line given as a string, e.g. from a job-file or a
+	// control-socket; it is split like a shell does, its first word is argv[0].
+	// The buffers for the words are kept for the next call.
+#if __cplusplus >= 201703L
+	bool parse(std::string_view cmdline, const char *usage = "", const char *doc = nullptr)
+#else
+	bool parse(const std::string &cmdline, const char *usage = "", const char *doc = nullptr)
+#endif
+	{
+		if (!split_command_line(cmdline.data(), cmdline.size(), cmdline_arena_, cmdline_argv_)) {
+			if (!(flags_ & ARGP_NO_ERRS))
+				fprintf(stderr, "%s: unterminated quote or escape in command line\n",
+				        program_invocation_short_name);
 			return false;
 		}
 
-		return true;
+		if (cmdline_argv_.size() == 1) // empty line, still needs argv[0]
+			cmdline_argv_.insert(cmdline_argv_.begin(), program_invocation_name);
+
+		return parse(cmdline_argv_.size() - 1, cmdline_argv_.data(), usage, doc);
+	}
+
+	// attributes for positional arguments, only prefetch applies
+	void set_argument_attributes(unsigned attributes) { argument_attributes_ = attributes; }
+
+	// bind the next positional argument to var, converted while parsing by the
+	// same conversion-function as an option; a type with the finalize
+	// attribute (file_list) takes all remaining arguments.
+	// The expected argument count is set accordingly.
+	template <typename T>
+	void add_argument(T &var)
+	{
+		add_argument_(make_check_function(var), option_attributes(&var) & finalize);
+	}
+
+	// bind all remaining positional arguments to var, each converted as an element
+	template <typename T>
+	void add_argument(std::vector<T> &var)
+	{
+		add_argument_([&var](int key, const char *arg, struct argp_state *state) {
+			var.emplace_back();
+			error_t ret = make_check_function(var.back())(key, arg, state);
+			if (ret != 0)
+				var.pop_back();
+			return ret;
+		}, false, true);
+	}
+
+	// positional arguments are additionally read from stdin when "-" is given
+	// as an argument or with --args-from-stdin, one per delimiter-terminated
+	// record, e.g. '\0' for the output of find -print0
+	void set_arguments_from_stdin(char delimiter = '\n')
+	{
+		if (!stdin_arguments_)
+			options_.insert(options_.end() - 1,
+			                {"args-from-stdin", args_from_stdin_key_, nullptr, 0,
+			                 "read further arguments from stdin"});
+		stdin_arguments_ = true;
+		stdin_delimiter_ = delimiter;
 	}
 
 	void add_flags(unsigned flags) { flags_ |= flags; }
 	void remove_flags(unsigned flags) { flags_ &= ~flags; }
 
+	// positional arguments are passed to callback while parsing instead
+	// of being stored for arguments()
+	void set_argument_callback(std::function<bool(const char *)> &&callback)
+	{
+		argument_callback_ = std::move(callback);
+	}
+
+	// positional arguments are pushed to queue while parsing, it is closed
+	// when parsing ends
+	void set_argument_queue(argument_queue &queue) { argument_queue_ = &queue; }
+
 	const std::vector<std::string> &arguments() const { return arguments_; }
+
+	// name of the invoked sub-command, empty if none was given
+	const std::string &subcommand() const { return subcommand_name_; }
+
+	// whether the last parse() printed the help or the usage (-?, --help,
+	// --usage), it returns false then as there is nothing to be run;
+	// only seen with ARGP_NO_EXIT as argp exits otherwise
+	bool help_shown() const { return help_shown_; }
 };
 } // namespace cxx_argp
 
@@ -0,0 +1,162 @@
+#include <cxx_argp_application.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "test.h"
+
+CXX_ARGP_APPLICATION_BOILERPLATE;
+
+class calculator : public cxx_argp::application
+{
+	int main() override { return serve(input_); }
+
+	int input_;
+	std::vector<int> numbers_;
+	bool negate_ = false;
+	std::string name_;
+
+public:
+	int builds = 0;
+	std::vector<int> sums;
+	std::string name;
+
+	explicit calculator(int input) : input_(input)
+	{
+		add_command("sum", "sum up numbers",
+		            [this](cxx_argp::parser &p) {
+			            p.add_option({"negate", 'n', nullptr, 0, "negate the sum"}, negate_);
+			            p.add_argument(numbers_);
+			            builds++;
+		            },
+		            [this]() {
+			            numbers_.clear();
+			            negate_ = false;
+		            },
+		            [this](const cxx_argp::parser &) {
+			            int sum = 0;
+			            for (auto n : numbers_)
+				            sum += n;
+			            sums.push_back(negate_ ? -sum : sum);
+			            return EXIT_SUCCESS;
+		            });
+
+		add_command("name", "set the name",
+		            [this](cxx_argp::parser &p) {
+			            p.add_argument(name_);
+		            },
+		            [this](const cxx_argp::parser &) {
+			            name = name_;
+			            return EXIT_SUCCESS;
+		            });
+	}
+};
+
+// read end of a pipe containing input
+static int input_from(const char *input)
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+		return -1;
+	if (write(fds[1], input, strlen(input)) != (ssize_t) strlen(input))
+		return -1;
+	close(fds[1]);
+	return fds[0];
+}
+
+static char *argv[] = {const_cast<char *>("program-name")};
+
+TEST(Application, serve)
+{
+	int fd = input_from("sum 1 2 3\n"
+	                    "\n"
+	                    "sum -n 4 5\n"
+	                    "name 'two words'\n"
+	                    "sum 10\n");
+	calculator app(fd);
+
+	EXPECT_EQ(app(1, argv), EXIT_SUCCESS);
+	close(fd);
+
+	EXPECT_EQ(app.builds, 1);
+	ASSERT_EQ(app.sums.size(), 3U);
+	EXPECT_EQ(app.sums[0], 6);
+	EXPECT_EQ(app.sums[1], -9);
+	EXPECT_EQ(app.sums[2], 10);
+	EXPECT_EQ(app.name, "two words");
+}
+
+TEST(Application, serve_errors)
+{
+	int fd = input_from("sum 1\nunknown\n");
+	calculator unknown(fd);
+	EXPECT_EQ(unknown(1, argv), EXIT_FAILURE);
+	EXPECT_EQ(unknown.sums.size(), 1U);
+	close(fd);
+
+	fd = input_from("name\nsum 2\n");
+	calculator invalid(fd);
+	EXPECT_EQ(invalid(1, argv), EXIT_SUCCESS);
+	EXPECT_EQ(invalid.name, "");
+	EXPECT_EQ(invalid.sums.size(), 1U);
+	close(fd);
+
+	// values bound by a command line which failed are reset
+	fd = input_from("sum -n 5 x\nsum 1\n");
+	calculator reset(fd);
+	EXPECT_EQ(reset(1, argv), EXIT_SUCCESS);
+	ASSERT_EQ(reset.sums.size(), 1U);
+	EXPECT_EQ(reset.sums[0], 1);
+	close(fd);
+}
+
+TEST(Application, serve_help)
+{
+	int fd = input_from("sum --help 1\n"
+	                    "sum -n -? 2\n"
+	                    "name --usage\n");
+	calculator app(fd);
+
+	EXPECT_EQ(app(1, argv), EXIT_SUCCESS);
+	close(fd);
+
+	EXPECT_EQ(app.sums.size(), 0U);
+	EXPECT_EQ(app.name, "");
+}
+
+// last, the application stays interrupted
+TEST(Application, serve_interrupted)
+{
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+	ASSERT_EQ(write(fds[1], "sum 1\n", 6), 6);
+
+	// the write-end stays open, serve() waits for the next line when the signal arrives
+	calculator app(fds[0]);
+	std::thread signal([] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		kill(getpid(), SIGINT);
+	});
+
+	EXPECT_EQ(app(1, argv), EXIT_SUCCESS);
+	signal.join();
+
+	EXPECT_EQ(cxx_argp::application::interrupted(), true);
+	EXPECT_EQ(app.sums.size(), 1U);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}
@@ -1,6 +1,8 @@
 #include <cxx_argp_parser.h>
 
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 #include "test.h"
 
@@ -238,6 +240,742 @@ TEST(CmdlineArgs, list_args)
 	EXPECT_EQ(main.args.vec[3], 4);
 }
 
+TEST(CmdlineArgs, subcommands)
+{
+	char *argv[] = {"program-name",
+	                "-e", "clone", "--depth", "3", "url", "-n", "common"};
+
+	bool enable = false;
+	std::string name;
+	int depth = 0;
+	bool push_built = false;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"enable", 'e', nullptr, 0, "enable"}, enable);
+	parser.add_option({"name", 'n', "name", 0, "a name"}, name);
+	parser.add_subcommand("clone", "clone a repository", [&depth](cxx_argp::parser &p) {
+		p.add_option({"depth", 'd', "depth", 0, "history depth"}, depth);
+	}, 1);
+	parser.add_subcommand("push", "push a repository", [&push_built](cxx_argp::parser &) {
+		push_built = true;
+	});
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(parser.subcommand(), "clone");
+	EXPECT_EQ(enable, true);
+	EXPECT_EQ(name, "common");
+	EXPECT_EQ(depth, 3);
+	EXPECT_EQ(push_built, false);
+	ASSERT_EQ(parser.arguments().size(), 1U);
+	EXPECT_EQ(parser.arguments()[0], "url");
+}
+
+TEST(CmdlineArgs, unknown_subcommand)
+{
+	char *argv[] = {"program-name",
+	                "-n", "clone", "pull"};
+
+	std::string name;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"name", 'n', "name", 0, "a name"}, name);
+	parser.add_subcommand("clone", "clone a repository", [](cxx_argp::parser &) {});
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+	EXPECT_EQ(parser.subcommand(), "");
+}
+
+TEST(CmdlineArgs, help_without_exit)
+{
+	char *argv[] = {"program-name", "clone", "--he"};
+	char *value[] = {"program-name", "clone", "-n", "--help", "url"};
+
+	std::string name;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"name", 'n', "name", 0, "a name"}, name);
+	parser.add_subcommand("clone", "clone a repository", [](cxx_argp::parser &) {}, 1);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+	EXPECT_EQ(parser.help_shown(), true);
+
+	// an argument looking like --help is no request for the help
+	ASSERT_EQ(parser.parse(sizeof(value) / sizeof(value[0]), value), true);
+	EXPECT_EQ(parser.help_shown(), false);
+	EXPECT_EQ(name, "--help");
+}
+
+TEST(CmdlineArgs, lazy_option_group_unused)
+{
+	char *argv[] = {"program-name",
+	                "-n", "name"};
+
+	std::string name;
+	int provided = 0;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"name", 'n', "name", 0, "a name"}, name);
+	parser.add_option_group("Plugin options:", [&provided](cxx_argp::parser &) {
+		provided++;
+	});
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(provided, 0);
+	EXPECT_EQ(name, "name");
+}
+
+TEST(CmdlineArgs, lazy_option_group_used)
+{
+	char *argv[] = {"program-name",
+	                "--level=3", "-x", "4"};
+
+	int level = 0;
+	int x = 0;
+	int first_provided = 0;
+	int second_provided = 0;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option_group("First plugin:", [&](cxx_argp::parser &p) {
+		first_provided++;
+		p.add_option({"level", 'l', "level", 0, "a level"}, level);
+	});
+	parser.add_option_group("Second plugin:", [&](cxx_argp::parser &p) {
+		second_provided++;
+		p.add_option({nullptr, 'x', "x", 0, "an x"}, x);
+	});
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(first_provided, 1);
+	EXPECT_EQ(second_provided, 1);
+	EXPECT_EQ(level, 3);
+	EXPECT_EQ(x, 4);
+}
+
+TEST(CmdlineArgs, lazy_option_group_version_names)
+{
+	// -V and abbreviations of --version are options of the group as long
+	// as the program has no version
+	char *argv[] = {"program-name", "-V", "1,2", "--ver"};
+
+	std::vector<int> vec;
+	bool verbose = false;
+	int provided = 0;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option_group("Plugin options:", [&](cxx_argp::parser &p) {
+		provided++;
+		p.add_option({"vector", 'V', "LIST", 0, "list of ints"}, vec);
+		p.add_option({"verbose", 0x1000, nullptr, 0, "be verbose"}, verbose);
+	});
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(provided, 1);
+	EXPECT_EQ(vec.size(), 2U);
+	EXPECT_EQ(verbose, true);
+}
+
+TEST(CmdlineArgs, lazy_option_group_exact_name)
+{
+	// --verbose abbreviates --verbose-log, but is the full name of an option
+	// of the group, which has to be provided
+	char *argv[] = {"program-name", "--verbose", "--verbose-l"};
+
+	int verbose = 0, verbose_log = 0;
+	int provided = 0;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"verbose-log", 0x1000, nullptr, 0, "log verbosely"},
+	                  [&verbose_log](const char *) { verbose_log++; return true; });
+	parser.add_option_group("Plugin options:", [&](cxx_argp::parser &p) {
+		provided++;
+		p.add_option({"verbose", 0x1001, nullptr, 0, "be verbose"},
+		             [&verbose](const char *) { verbose++; return true; });
+	});
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(provided, 1);
+	EXPECT_EQ(verbose, 1);
+	EXPECT_EQ(verbose_log, 1);
+}
+
+TEST(CmdlineArgs, lazy_values)
+{
+	char *argv[] = {"program-name",
+	                "-f", "/bin/sh", "-V", "1,2", "-V", "3", "-p", "99999999999999999999"};
+
+	cxx_argp::lazy<std::ifstream> file;
+	cxx_argp::lazy<std::vector<int>> vec;
+	cxx_argp::lazy<double> unused{1.5};
+	cxx_argp::lazy<int> port;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"file", 'f', "filename", 0, "a file"}, file);
+	parser.add_option({"vector", 'V', "list", 0, "list of ints"}, vec);
+	parser.add_option({"double", 'd', "double", 0, "floating-point test"}, unused);
+	parser.add_option({"port", 'p', "port", 0, "port"}, port);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(file.given(), true);
+	EXPECT_EQ(file.converted(), false);
+	EXPECT_EQ(file->is_open(), true);
+	EXPECT_EQ(file.converted(), true);
+
+	EXPECT_EQ(vec->size(), 3U);
+	EXPECT_EQ(vec.get()[2], 3);
+
+	EXPECT_EQ(unused.given(), false);
+	EXPECT_EQ(*unused, 1.5);
+
+	EXPECT_EQ(port.error().empty(), false);
+}
+
+TEST(CmdlineArgs, lazy_values_reparsed)
+{
+	char *argv[] = {"program-name", "-V", "1,2"};
+	char *none[] = {"program-name"};
+
+	cxx_argp::lazy<std::vector<int>> vec{{7}};
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"vector", 'V', "list", 0, "list of ints"}, vec);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+	EXPECT_EQ(vec.given(), true);
+	EXPECT_EQ(vec->size(), 3U);
+	EXPECT_EQ(vec.get()[0], 7);
+
+	ASSERT_EQ(parser.parse(sizeof(none) / sizeof(none[0]), none), true);
+	EXPECT_EQ(vec.given(), false);
+	EXPECT_EQ(vec->size(), 1U);
+}
+
+TEST(CmdlineArgs, lazy_values_checked)
+{
+	char *argv[] = {"program-name",
+	                "-f", "/should-not-exist"};
+
+	cxx_argp::lazy<std::ifstream> file;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"file", 'f', "filename", 0, "a file"}, file);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+}
+
+TEST(CmdlineArgs, expensive_options)
+{
+	char *argv[] = {"program-name",
+	                "-a", "1", "-b", "2", "-V", "1,2", "-V", "3", "-n", "name"};
+
+	std::atomic<int> a{0}, b{0};
+	std::vector<int> vec;
+	std::string name;
+
+	auto slow = [](std::atomic<int> &x) {
+		return [&x](const char *arg) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			x = atoi(arg);
+			return true;
+		};
+	};
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({nullptr, 'a', "a", 0, "a"}, slow(a), cxx_argp::expensive);
+	parser.add_option({nullptr, 'b', "b", 0, "b"}, slow(b), cxx_argp::expensive);
+	parser.add_option({"vector", 'V', "list", 0, "list of ints"}, vec, cxx_argp::expensive);
+	parser.add_option({"name", 'n', "name", 0, "a name"}, name);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(a.load(), 1);
+	EXPECT_EQ(b.load(), 2);
+	ASSERT_EQ(vec.size(), 3U);
+	EXPECT_EQ(vec[2], 3);
+	EXPECT_EQ(name, "name");
+}
+
+TEST(CmdlineArgs, expensive_option_fails)
+{
+	char *argv[] = {"program-name",
+	                "-f", "/should-not-exist"};
+
+	std::ifstream file;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"file", 'f', "filename", 0, "a file"}, file, cxx_argp::expensive);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+}
+
+TEST(CmdlineArgs, prefetched_files)
+{
+	char *argv[] = {"program-name",
+	                "-i", "/bin/sh", "/etc/passwd", "/should-not-exist"};
+
+	std::pair<std::ifstream, std::string> input;
+
+	cxx_argp::parser parser(2);
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"input", 'i', "filename", 0, "filename and file"}, input,
+	                  cxx_argp::prefetch);
+	parser.set_argument_attributes(cxx_argp::prefetch);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(input.first.is_open(), true);
+	EXPECT_EQ(parser.arguments()[1], "/should-not-exist");
+}
+
+TEST(CmdlineArgs, argument_callback)
+{
+	char *argv[] = {"program-name",
+	                "-n", "name", "first", "second"};
+
+	std::string name;
+	std::vector<std::string> seen;
+
+	cxx_argp::parser parser(2);
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"name", 'n', "name", 0, "a name"}, name);
+	parser.set_argument_callback([&](const char *arg) {
+		seen.push_back(arg + std::string(":") + name);
+		return true;
+	});
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(parser.arguments().size(), 0U);
+	ASSERT_EQ(seen.size(), 2U);
+	EXPECT_EQ(seen[0], "first:name");
+	EXPECT_EQ(seen[1], "second:name");
+}
+
+TEST(CmdlineArgs, argument_queue)
+{
+	char *argv[] = {"program-name",
+	                "1", "2", "3", "4", "5"};
+
+	cxx_argp::argument_queue queue(2);
+
+	int sum = 0;
+	std::thread consumer([&queue, &sum] {
+		std::string arg;
+		while (queue.pop(arg))
+			sum += std::stoi(arg);
+	});
+
+	cxx_argp::parser parser(-1);
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.set_argument_queue(queue);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	consumer.join();
+	EXPECT_EQ(sum, 15);
+}
+
+TEST(CmdlineArgs, typed_arguments)
+{
+	char *argv[] = {"program-name",
+	                "42", "name", "1.5", "-v", "2.5"};
+
+	int id = 0;
+	std::string name;
+	std::vector<double> values;
+	bool verbose = false;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"verbose", 'v', nullptr, 0, "verbose"}, verbose);
+	parser.add_argument(id);
+	parser.add_argument(name);
+	parser.add_argument(values);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(id, 42);
+	EXPECT_EQ(name, "name");
+	ASSERT_EQ(values.size(), 2U);
+	EXPECT_EQ(values[1], 2.5);
+	EXPECT_EQ(parser.arguments().size(), 0U);
+}
+
+TEST(CmdlineArgs, typed_arguments_count)
+{
+	char *few[] = {"program-name", "42"};
+	char *many[] = {"program-name", "42", "name", "7"};
+
+	int id = 0;
+	std::string name;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_argument(id);
+	parser.add_argument(name);
+
+	EXPECT_EQ(parser.parse(sizeof(few) / sizeof(few[0]), few), false);
+	EXPECT_EQ(parser.parse(sizeof(many) / sizeof(many[0]), many), false);
+
+	std::vector<int> rest;
+	parser.add_argument(rest);
+
+	EXPECT_EQ(parser.parse(sizeof(few) / sizeof(few[0]), few), false);
+	EXPECT_EQ(parser.parse(sizeof(many) / sizeof(many[0]), many), true);
+	ASSERT_EQ(rest.size(), 1U);
+	EXPECT_EQ(rest[0], 7);
+}
+
+TEST(CmdlineArgs, command_line_string)
+{
+	std::string name;
+	int count = 0;
+
+	cxx_argp::parser parser(-1);
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"name", 'n', "name", 0, "a name"}, name);
+	parser.add_option({"count", 'c', "count", 0, "a count"}, count);
+
+	ASSERT_EQ(parser.parse("prog  -n 'single quoted'\t--count=12 \"a \\\"b\\\" $c\" d\\ e ''"), true);
+
+	EXPECT_EQ(name, "single quoted");
+	EXPECT_EQ(count, 12);
+	ASSERT_EQ(parser.arguments().size(), 3U);
+	EXPECT_EQ(parser.arguments()[0], "a \"b\" $c");
+	EXPECT_EQ(parser.arguments()[1], "d e");
+	EXPECT_EQ(parser.arguments()[2], "");
+
+	// the parser is reused with another line
+	ASSERT_EQ(parser.parse("prog x"), true);
+	ASSERT_EQ(parser.arguments().size(), 1U);
+	EXPECT_EQ(parser.arguments()[0], "x");
+
+	EXPECT_EQ(parser.parse("prog 'unterminated"), false);
+	EXPECT_EQ(parser.parse(""), true);
+}
+
+static constexpr cxx_argp::flag features[] = {
+	{"compress", 0},
+	{"checksum", 1},
+	{"encrypt", 5},
+};
+
+TEST(CmdlineArgs, feature_flags)
+{
+	char *argv[] = {"program-name",
+	                "--features", "compress,encrypt", "-f", "-compress,+checksum",
+	                "-m", "encrypt"};
+
+	std::bitset<8> enabled("00000001"); // compress by default
+	unsigned mask = 0;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"features", 'f', "LIST", 0, "features"}, enabled, features);
+	parser.add_option({"mask", 'm', "LIST", 0, "features as mask"}, mask, features);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(enabled.to_string(), "00100010");
+	EXPECT_EQ(mask, 1U << 5);
+
+	std::string message;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(mask, features), 'm', "checksum,zip", message), EINVAL);
+	EXPECT_EQ(message.find("'zip' is not one of compress, checksum, encrypt") != std::string::npos, true);
+
+	// bits the set or the mask does not have
+	std::bitset<4> small;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(small, features), 'f', "compress", message), EINVAL);
+	EXPECT_EQ(message.find("bit 5 of 'encrypt' is beyond the 4 bits") != std::string::npos, true);
+
+	static constexpr cxx_argp::flag wide[] = {{"low", 0}, {"high", 8}};
+	static_assert(cxx_argp::flags_fit(features, 8) && !cxx_argp::flags_fit(wide, 8), "flags_fit");
+	uint8_t byte = 0;
+	int8_t signed_byte = 0;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(byte, wide), 'f', "low", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(signed_byte, features), 'f', "encrypt", message), 0);
+	EXPECT_EQ(byte, 0);
+	EXPECT_EQ(signed_byte, 1 << 5);
+	uint16_t word = 0;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(word, wide), 'f', "high,low", message), 0);
+	EXPECT_EQ(word, 0x101);
+}
+
+TEST(CmdlineArgs, numeric_errors)
+{
+	int i = 5;
+	double d = 1.5;
+	std::string message;
+
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(i), 'i', "abc", message), EINVAL);
+	EXPECT_EQ(message.find("unable to interpret 'abc' as a whole number") != std::string::npos, true);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(i), 'i', "99999999999999999999", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(i), 'i', "12x", message), EINVAL);
+	EXPECT_EQ(message.find("trailing characters after number in '12x'") != std::string::npos, true);
+	EXPECT_EQ(i, 5);
+
+	// beyond the range of the variable
+	int8_t small = 0;
+	unsigned positive = 0;
+	float single = 0;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(small), 's', "128", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(small), 's', "-129", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(small), 's', "-128", message), 0);
+	EXPECT_EQ(small, -128);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(positive), 'u', " -1", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(positive), 'u', "4294967296", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(positive), 'u', "4294967295", message), 0);
+	EXPECT_EQ(positive, 4294967295U);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(single), 'f', "1e39", message), EINVAL);
+	EXPECT_EQ(single, 0.0f);
+
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(d), 'd', "", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(d), 'd', "1e999", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(d), 'd', "2.5s", message), EINVAL);
+	EXPECT_EQ(d, 1.5);
+
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(i), 'i', "-42", message), 0);
+	EXPECT_EQ(i, -42);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(d), 'd', "2.5", message), 0);
+	EXPECT_EQ(d, 2.5);
+}
+
+TEST(CmdlineArgs, bulk_options)
+{
+	const int count = 1000;
+	std::vector<std::string> names;
+	std::vector<int> values(count);
+	for (int i = 0; i < count; i++)
+		names.push_back("option-" + std::to_string(i));
+
+	std::vector<cxx_argp::option_binding> bindings;
+	for (int i = 0; i < count; i++)
+		bindings.emplace_back(argp_option{names[i].c_str(), 0x1000 + i, "INT", 0, "generated"}, values[i]);
+
+	int verbose = 0;
+	std::string name;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.reserve(count + 2);
+	ASSERT_EQ(parser.add_options(bindings), true);
+	ASSERT_EQ(parser.add_options({{{"verbose", 'v', "LEVEL", 0, "verbosity"}, verbose},
+	                              {{"name", 'n', "NAME", 0, "name"}, name}}), true);
+
+	// duplicate keys, within the range or with those added before, add nothing
+	int other = 0;
+	EXPECT_EQ(parser.add_options({{{"other", 'o', "INT", 0, "other"}, other},
+	                              {{"again", 'o', "INT", 0, "again"}, other}}), false);
+	EXPECT_EQ(parser.add_options({{{"other", 'o', "INT", 0, "other"}, other},
+	                              {{"verbose2", 'v', "INT", 0, "again"}, other}}), false);
+	EXPECT_EQ(parser.add_option({"other", 'v', "INT", 0, "other"}, other), false);
+
+	char *argv[] = {"program-name", "--option-0", "10", "--option-999=999", "-v", "2", "-n", "x", "--option-500", "5"};
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(values[0], 10);
+	EXPECT_EQ(values[500], 5);
+	EXPECT_EQ(values[999], 999);
+	EXPECT_EQ(values[1], 0);
+	EXPECT_EQ(verbose, 2);
+	EXPECT_EQ(name, "x");
+
+	char *invalid[] = {"program-name", "-o", "1"};
+	EXPECT_EQ(parser.parse(sizeof(invalid) / sizeof(invalid[0]), invalid), false);
+}
+
+TEST(CmdlineArgs, option_alias)
+{
+	char *argv[] = {"program-name", "--colour", "3", "--length", "2"};
+
+	int c = 0;
+	int size = 0;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	ASSERT_EQ(parser.add_option({"color", 'c', "N", 0, "color"}, c), true);
+	ASSERT_EQ(parser.add_option({"colour", 'c', nullptr, OPTION_ALIAS}, c), true);
+	ASSERT_EQ(parser.add_options({{{"size", 's', "N", 0, "size"}, size},
+	                              {{"length", 's', nullptr, OPTION_ALIAS}, size}}), true);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+	EXPECT_EQ(c, 3);
+	EXPECT_EQ(size, 2);
+}
+
+// replace stdin by fd for the lifetime of the object
+struct stdin_from
+{
+	int saved = dup(STDIN_FILENO);
+
+	explicit stdin_from(int fd)
+	{
+		dup2(fd, STDIN_FILENO);
+		close(fd);
+	}
+	~stdin_from()
+	{
+		dup2(saved, STDIN_FILENO);
+		close(saved);
+	}
+};
+
+TEST(CmdlineArgs, arguments_from_stdin_pipe)
+{
+	char *argv[] = {"program-name",
+	                "first", "-", "last"};
+
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+	const char input[] = "a\nb\n\nc";
+	ASSERT_EQ(write(fds[1], input, sizeof(input) - 1), (ssize_t) sizeof(input) - 1);
+	close(fds[1]);
+	stdin_from redirect(fds[0]);
+
+	cxx_argp::parser parser(-1);
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.set_arguments_from_stdin();
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	ASSERT_EQ(parser.arguments().size(), 5U);
+	EXPECT_EQ(parser.arguments()[0], "first");
+	EXPECT_EQ(parser.arguments()[1], "a");
+	EXPECT_EQ(parser.arguments()[2], "b");
+	EXPECT_EQ(parser.arguments()[3], "c");
+	EXPECT_EQ(parser.arguments()[4], "last");
+}
+
+TEST(CmdlineArgs, arguments_from_stdin_file)
+{
+	char *argv[] = {"program-name",
+	                "--args-from-stdin", "first"};
+
+	char name[] = "/tmp/cxx-argp-test-XXXXXX";
+	int fd = mkstemp(name);
+	ASSERT_EQ(fd >= 0, true);
+	unlink(name);
+
+	const char input[] = "with space\0second\nline\0";
+	ASSERT_EQ(write(fd, input, sizeof(input) - 1), (ssize_t) sizeof(input) - 1);
+	lseek(fd, 0, SEEK_SET);
+	stdin_from redirect(fd);
+
+	cxx_argp::parser parser(3);
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.set_arguments_from_stdin('\0');
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	ASSERT_EQ(parser.arguments().size(), 3U);
+	EXPECT_EQ(parser.arguments()[0], "first");
+	EXPECT_EQ(parser.arguments()[1], "with space");
+	EXPECT_EQ(parser.arguments()[2], "second\nline");
+}
+
+static std::string complete(cxx_argp::parser &parser, int argc, char *argv[])
+{
+	char *buffer = nullptr;
+	size_t size = 0;
+	FILE *out = open_memstream(&buffer, &size);
+	parser.complete(argc, argv, out);
+	fclose(out);
+
+	std::string result(buffer, size);
+	free(buffer);
+	return result;
+}
+
+TEST(CmdlineArgs, completion)
+{
+	char *options[] = {"program-name", "-e", "--na"};
+	char *values[] = {"program-name", "--mode", "f"};
+	char *commands[] = {"program-name", "-n", "x", "c"};
+	char *subcommand_options[] = {"program-name", "clone", "--d"};
+
+	bool enable = false;
+	std::string name, mode;
+	int depth = 0;
+	int converted = 0;
+
+	cxx_argp::parser parser;
+	parser.add_option({"enable", 'e', nullptr, 0, "enable"}, enable);
+	parser.add_option({"name", 'n', "name", 0, "a name"},
+	                  [&converted](const char *) { converted++; return true; });
+	parser.add_option({"mode", 'm', "mode", 0, "a mode"}, mode);
+	parser.add_completion('m', {"fast", "slow", "fastest"});
+	parser.add_subcommand("clone", "clone a repository", [&depth](cxx_argp::parser &p) {
+		p.add_option({"depth", 'd', "depth", 0, "history depth"}, depth);
+	});
+	parser.add_subcommand("push", "push a repository", [](cxx_argp::parser &) {});
+
+	EXPECT_EQ(complete(parser, 3, options), "--name\n");
+	EXPECT_EQ(complete(parser, 3, values), "fast\nfastest\n");
+	EXPECT_EQ(complete(parser, 4, commands), "clone\n");
+	EXPECT_EQ(complete(parser, 3, subcommand_options), "--depth\n");
+	EXPECT_EQ(converted, 0);
+	EXPECT_EQ(enable, false);
+}
+
+enum class mode { fast, safe, paranoid };
+
+static constexpr cxx_argp::keyword<mode> modes[] = {
+	{"fast", mode::fast},
+	{"safe", mode::safe},
+	{"paranoid", mode::paranoid},
+};
+
+TEST(CmdlineArgs, keywords)
+{
+	char *argv[] = {"program-name",
+	                "--mode", "paranoid"};
+
+	mode m = mode::fast;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"mode", 'm', "MODE", 0, "operating mode"}, m, modes);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+	EXPECT_EQ(m == mode::paranoid, true);
+
+	std::string message;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(m, modes), 'm', "saf", message), EINVAL);
+	EXPECT_EQ(message.find("'saf' is not one of fast, safe, paranoid") != std::string::npos, true);
+	EXPECT_EQ(m == mode::paranoid, true);
+
+	char *values[] = {"program-name", "-m", "p"};
+	EXPECT_EQ(complete(parser, 3, values), "paranoid\n");
+
+	// a used key adds nothing, not even completions
+	static constexpr cxx_argp::keyword<mode> others[] = {{"portable", mode::fast}};
+	static constexpr cxx_argp::flag flags[] = {{"pretty", 0}};
+	mode other = mode::fast;
+	unsigned mask = 0;
+	EXPECT_EQ(parser.add_option({"other", 'm', "MODE", 0, "other mode"}, other, others), false);
+	EXPECT_EQ(parser.add_option({"flags", 'm', "LIST", 0, "flags"}, mask, flags), false);
+	EXPECT_EQ(parser.add_option({"flags", 'F', "LIST", 0, "flags"}, mask, flags), true);
+	EXPECT_EQ(complete(parser, 3, values), "paranoid\n");
+}
+
 int main(void)
 {
 #if 0
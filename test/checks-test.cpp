@@ -0,0 +1,113 @@
+#include <cxx_argp_checks.h>
+
+#include <iostream>
+
+#include "test.h"
+
+// creating real argv-strings here
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+
+TEST(Checks, passing)
+{
+	char *argv[] = {"program-name",
+	                "-p", "443", "-b", "4096", "-l", "3", "-n", "name", "-c", "/etc/passwd", "-o", "-5"};
+
+	unsigned port = 0;
+	size_t block = 0;
+	int level = 0, offset = 0;
+	std::string name, config;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({nullptr, 'p', "PORT", 0, "port"}, cxx_argp::checked<cxx_argp::range<1, 65535>>(port));
+	parser.add_option({nullptr, 'b', "SIZE", 0, "block size"},
+	                  cxx_argp::checked<cxx_argp::power_of_two, cxx_argp::range<512, 65536>>(block));
+	parser.add_option({nullptr, 'l', "LEVEL", 0, "level"}, cxx_argp::checked<cxx_argp::one_of<1, 3, 9>>(level));
+	parser.add_option({nullptr, 'n', "NAME", 0, "name"}, cxx_argp::checked<cxx_argp::non_empty>(name));
+	parser.add_option({nullptr, 'c', "FILE", 0, "config"}, cxx_argp::checked<cxx_argp::path_exists>(config));
+	parser.add_option({nullptr, 'o', "OFFSET", 0, "offset"}, cxx_argp::checked<cxx_argp::range<-10, 10>>(offset));
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(port, 443U);
+	EXPECT_EQ(block, 4096U);
+	EXPECT_EQ(level, 3);
+	EXPECT_EQ(name, "name");
+	EXPECT_EQ(config, "/etc/passwd");
+	EXPECT_EQ(offset, -5);
+}
+
+// a check of a list's length
+struct at_most_two
+{
+	template <typename T>
+	static bool check(const T &value, const char *arg, struct argp_state *state)
+	{
+		if (value.size() <= 2)
+			return true;
+		argp_error(state, "'%s' makes more than two", arg);
+		return false;
+	}
+};
+
+TEST(Checks, failing)
+{
+	unsigned port = 0;
+	size_t block = 0;
+	int level = 0;
+	std::string name;
+
+	std::string message;
+	auto port_check = cxx_argp::checked<cxx_argp::range<1, 65535>>(port);
+	EXPECT_EQ(cxx_argp::convert_silently(port_check, 'p', "0", message), EINVAL);
+	EXPECT_EQ(message.find("'0' is not between 1 and 65535") != std::string::npos, true);
+	EXPECT_EQ(cxx_argp::convert_silently(port_check, 'p', "65536", message), EINVAL);
+
+	auto block_check = cxx_argp::checked<cxx_argp::power_of_two, cxx_argp::range<512, 65536>>(block);
+	EXPECT_EQ(cxx_argp::convert_silently(block_check, 'b', "1000", message), EINVAL);
+	EXPECT_EQ(message.find("not a power of two") != std::string::npos, true);
+	EXPECT_EQ(cxx_argp::convert_silently(block_check, 'b', "256", message), EINVAL);
+	EXPECT_EQ(message.find("not between") != std::string::npos, true);
+
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::checked<cxx_argp::one_of<1, 3, 9>>(level), 'l', "2", message), EINVAL);
+	EXPECT_EQ(message.find("'2' is not one of 1, 3, 9") != std::string::npos, true);
+
+	// not narrowed to the type of the variable before the check
+	uint16_t short_port = 0;
+	auto short_port_check = cxx_argp::checked<cxx_argp::range<1, 65535>>(short_port);
+	EXPECT_EQ(cxx_argp::convert_silently(short_port_check, 'p', "70000", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(port_check, 'p', "4294967297", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(port_check, 'p', "-1", message), EINVAL);
+	EXPECT_EQ(short_port, 0);
+
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::checked<cxx_argp::non_empty>(name), 'n', "", message), EINVAL);
+
+	// a rejected value is not assigned
+	unsigned limited = 80;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::checked<cxx_argp::range<1, 1000>>(limited), 'p', "5000", message), EINVAL);
+	EXPECT_EQ(limited, 80U);
+
+	// types without convert_value() use their conversion-function
+	static_assert(!cxx_argp::has_convert_value<std::vector<int>>::value, "vector");
+	static_assert(cxx_argp::has_convert_value<int>::value && cxx_argp::has_convert_value<std::string>::value, "int");
+	std::vector<int> list;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::checked<cxx_argp::non_empty>(list), 'l', "1,2", message), 0);
+	EXPECT_EQ(list.size(), 2U);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::checked<at_most_two>(list), 'l', "3", message), EINVAL);
+	EXPECT_EQ(list.size(), 2U);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::checked<cxx_argp::path_exists>(name), 'c', "/should-not-exist", message), EINVAL);
+	EXPECT_EQ(message.find("No such file") != std::string::npos, true);
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}
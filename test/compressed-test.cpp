@@ -0,0 +1,175 @@
+#include <cxx_argp_compressed.h>
+
+#include <iostream>
+#include <iterator>
+
+#include "test.h"
+
+// creating real argv-strings here
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+
+static std::string content()
+{
+	std::string data;
+	for (int i = 0; i < 100000; i++)
+		data += "line " + std::to_string(i) + " of the test-content\n";
+	return data;
+}
+
+static void write_gzip(const char *filename, const std::string &data)
+{
+	// two members, read as one stream
+	size_t half = data.size() / 2;
+	gzFile file = gzopen(filename, "wb");
+	gzwrite(file, data.data(), half);
+	gzclose(file);
+	file = gzopen(filename, "ab");
+	gzwrite(file, data.data() + half, data.size() - half);
+	gzclose(file);
+}
+
+static void write_xz(const char *filename, const std::string &data)
+{
+	std::vector<uint8_t> out(data.size() + 1024);
+	size_t size = 0;
+	lzma_easy_buffer_encode(1, LZMA_CHECK_CRC64, nullptr,
+	                        reinterpret_cast<const uint8_t *>(data.data()), data.size(),
+	                        out.data(), &size, out.size());
+	std::ofstream(filename).write(reinterpret_cast<const char *>(out.data()), size);
+}
+
+#ifdef CXX_ARGP_HAS_ZSTD
+static void write_zstd(const char *filename, const std::string &data)
+{
+	// two frames, read as one stream
+	std::ofstream file(filename);
+	size_t half = data.size() / 2;
+	const char *part[] = {data.data(), data.data() + half};
+	size_t size[] = {half, data.size() - half};
+	for (int i = 0; i < 2; i++) {
+		std::vector<char> out(ZSTD_compressBound(size[i]));
+		size_t n = ZSTD_compress(out.data(), out.size(), part[i], size[i], 1);
+		file.write(out.data(), n);
+	}
+}
+#endif
+
+static std::string read_all(std::istream &stream)
+{
+	return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+TEST(Compressed, formats)
+{
+	const std::string data = content();
+	write_gzip("/tmp/cxx-argp-test.gz", data);
+	write_xz("/tmp/cxx-argp-test.xz", data);
+	std::ofstream("/tmp/cxx-argp-test.txt") << data;
+
+	char *argv[] = {"program-name",
+	                "-g", "/tmp/cxx-argp-test.gz",
+	                "-x", "/tmp/cxx-argp-test.xz",
+	                "-r", "/tmp/cxx-argp-test.txt"};
+
+	cxx_argp::compressed_ifstream gz, raw;
+	std::pair<cxx_argp::compressed_ifstream, std::string> xz;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"gzip", 'g', "filename", 0, "gzip-file"}, gz);
+	parser.add_option({"xz", 'x', "filename", 0, "xz-file and name"}, xz);
+	parser.add_option({"raw", 'r', "filename", 0, "uncompressed file"}, raw);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(gz.compression(), cxx_argp::decompressing_streambuf::gzip);
+	EXPECT_EQ(xz.first.compression(), cxx_argp::decompressing_streambuf::xz);
+	EXPECT_EQ(xz.second, "/tmp/cxx-argp-test.xz");
+	EXPECT_EQ(raw.compression(), cxx_argp::decompressing_streambuf::raw);
+
+	EXPECT_EQ(read_all(gz) == data, true);
+	EXPECT_EQ(read_all(xz.first) == data, true);
+	EXPECT_EQ(read_all(raw) == data, true);
+	EXPECT_EQ(gz.error(), "");
+
+	unlink("/tmp/cxx-argp-test.gz");
+	unlink("/tmp/cxx-argp-test.xz");
+	unlink("/tmp/cxx-argp-test.txt");
+}
+
+TEST(Compressed, truncated)
+{
+	const std::string data = content();
+	write_gzip("/tmp/cxx-argp-test.gz", data);
+	truncate("/tmp/cxx-argp-test.gz", 1000);
+
+	cxx_argp::compressed_ifstream gz{"/tmp/cxx-argp-test.gz"};
+	ASSERT_EQ(gz.is_open(), true);
+
+	EXPECT_EQ(read_all(gz).size() < data.size(), true);
+	EXPECT_EQ(gz.error(), "unexpected end of gzip-data");
+
+	unlink("/tmp/cxx-argp-test.gz");
+}
+
+#ifdef CXX_ARGP_HAS_ZSTD
+TEST(Compressed, zstd)
+{
+	const std::string data = content();
+	write_zstd("/tmp/cxx-argp-test.zst", data);
+
+	cxx_argp::compressed_ifstream zst{"/tmp/cxx-argp-test.zst"};
+	ASSERT_EQ(zst.is_open(), true);
+
+	EXPECT_EQ(zst.compression(), cxx_argp::decompressing_streambuf::zstd);
+	EXPECT_EQ(read_all(zst) == data, true);
+	EXPECT_EQ(zst.error(), "");
+
+	write_zstd("/tmp/cxx-argp-test.zst", data);
+	truncate("/tmp/cxx-argp-test.zst", 1000);
+
+	cxx_argp::compressed_ifstream truncated{"/tmp/cxx-argp-test.zst"};
+	EXPECT_EQ(read_all(truncated).size() < data.size(), true);
+	EXPECT_EQ(truncated.error(), "unexpected end of zstd-data");
+
+	unlink("/tmp/cxx-argp-test.zst");
+}
+#else
+TEST(Compressed, zstd_not_enabled)
+{
+	std::ofstream("/tmp/cxx-argp-test.zst").write("\x28\xb5\x2f\xfd" "data", 8);
+
+	cxx_argp::compressed_ifstream zst{"/tmp/cxx-argp-test.zst"};
+	EXPECT_EQ(read_all(zst), "");
+	EXPECT_EQ(zst.error(), "zstd-support not available");
+
+	unlink("/tmp/cxx-argp-test.zst");
+}
+#endif
+
+TEST(Compressed, missing)
+{
+	char *argv[] = {"program-name",
+	                "-g", "/should-not-exist"};
+
+	cxx_argp::compressed_ifstream gz;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"gzip", 'g', "filename", 0, "gzip-file"}, gz);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}
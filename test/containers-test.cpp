@@ -0,0 +1,168 @@
+#include <cxx_argp_containers.h>
+
+#include <iostream>
+
+#include "test.h"
+
+// creating real argv-strings here
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+
+TEST(Containers, flat_map)
+{
+	char *argv[] = {"program-name",
+	                "-D", "name=first", "-D", "empty=", "-D", "name=second=last",
+	                "-L", "a=1", "-L", "b=22"};
+
+	cxx_argp::flat_map<> defines;
+	cxx_argp::flat_map<int> limits;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"define", 'D', "KEY=VALUE", 0, "define"}, defines);
+	parser.add_option({"limit", 'L', "KEY=NUMBER", 0, "limit"}, limits);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	ASSERT_EQ(defines.size(), 2U);
+	ASSERT_EQ(defines.find("name") != nullptr, true);
+	EXPECT_EQ(std::string(*defines.find("name")), "second=last");
+	EXPECT_EQ(std::string(*defines.find(std::string("empty"))), "");
+	EXPECT_EQ(defines.find("nam") == nullptr, true);
+
+	ASSERT_EQ(limits.size(), 2U);
+	EXPECT_EQ(*limits.find("b"), 22);
+
+	std::string message;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(limits), 'L', "=1", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(limits), 'L', "c", message), EINVAL);
+	EXPECT_EQ(limits.size(), 2U);
+}
+
+TEST(Containers, flat_map_many)
+{
+	cxx_argp::flat_map<size_t> map;
+	for (size_t i = 0; i < 1000; i++) {
+		std::string key = "key-" + std::to_string(i);
+		map(key.data(), key.size()) = i;
+	}
+
+	EXPECT_EQ(map.size(), 1000U);
+
+	size_t found = 0;
+	for (size_t i = 0; i < 1000; i++) {
+		auto value = map.find("key-" + std::to_string(i));
+		if (value && *value == i)
+			found++;
+	}
+	EXPECT_EQ(found, 1000U);
+
+	size_t sum = 0;
+	map.for_each([&sum](const char *, size_t value) { sum += value; });
+	EXPECT_EQ(sum, 999U * 1000 / 2);
+}
+
+TEST(Containers, flat_set)
+{
+	char name[] = "/tmp/cxx-argp-test-XXXXXX";
+	int fd = mkstemp(name);
+	ASSERT_EQ(fd >= 0, true);
+	const char ids[] = "# excluded ids\n17\n  42 \n\n18446744073709551615\n";
+	ASSERT_EQ(write(fd, ids, sizeof(ids) - 1), (ssize_t) sizeof(ids) - 1);
+	close(fd);
+
+	std::string file = std::string("@") + name;
+	char *argv[] = {"program-name",
+	                "--exclude-ids", &file[0], "-x", "7,8",
+	                "--users", "alice, bob"};
+
+	cxx_argp::flat_set<uint64_t> exclude(true);
+	cxx_argp::flat_set<> users;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"exclude-ids", 'x', "ID,...|@FILE", 0, "excluded ids"}, exclude);
+	parser.add_option({"users", 'u', "NAME,...|@FILE", 0, "allowed users"}, users);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+	unlink(name);
+
+	EXPECT_EQ(exclude.size(), 5U);
+	EXPECT_EQ(exclude.contains(42), true);
+	EXPECT_EQ(exclude.contains(8), true);
+	EXPECT_EQ(exclude.contains(43), false);
+	EXPECT_EQ(exclude.contains(UINT64_MAX), true);
+
+	EXPECT_EQ(users.size(), 2U);
+	EXPECT_EQ(users.contains("bob"), true);
+	EXPECT_EQ(users.contains(std::string("alice")), true);
+	EXPECT_EQ(users.contains("alic"), false);
+
+	std::string message;
+	cxx_argp::flat_set<uint8_t> small;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(small), 'x', "1,256", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(small), 'x', "1,-1", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(small), 'x', "@/should-not-exist", message), EINVAL);
+	EXPECT_EQ(small.contains(1), true);
+}
+
+TEST(Containers, flat_set_invalid_line)
+{
+	const char ids[] = "17\n42\nnot-a-number\n43\n";
+	std::string message;
+
+	// from a regular file, which is mapped
+	char name[] = "/tmp/cxx-argp-test-XXXXXX";
+	int fd = mkstemp(name);
+	ASSERT_EQ(fd >= 0, true);
+	ASSERT_EQ(write(fd, ids, sizeof(ids) - 1), (ssize_t) sizeof(ids) - 1);
+	close(fd);
+
+	cxx_argp::flat_set<uint64_t> from_file;
+	std::string file = std::string("@") + name;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(from_file), 'x', file.c_str(), message), EINVAL);
+	EXPECT_EQ(message.find("invalid value 'not-a-number' in '" + std::string(name) + "'") != std::string::npos, true);
+	unlink(name);
+
+	// from a pipe, which is read in blocks
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+	ASSERT_EQ(write(fds[1], ids, sizeof(ids) - 1), (ssize_t) sizeof(ids) - 1);
+	close(fds[1]);
+
+	cxx_argp::flat_set<uint64_t> from_pipe;
+	std::string pipe_file = "@/dev/fd/" + std::to_string(fds[0]);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(from_pipe), 'x', pipe_file.c_str(), message), EINVAL);
+	EXPECT_EQ(message.find("invalid value 'not-a-number' in '/dev/fd/") != std::string::npos, true);
+	EXPECT_EQ(from_pipe.contains(42), true);
+	EXPECT_EQ(from_pipe.contains(43), false);
+	close(fds[0]);
+}
+
+TEST(Containers, flat_set_many)
+{
+	cxx_argp::flat_set<int> plain;
+	cxx_argp::flat_set<int> bloom(true);
+	for (int i = -5000; i < 5000; i += 2) {
+		plain.insert(i);
+		bloom.insert(i);
+	}
+
+	size_t found = 0;
+	for (int i = -5000; i < 5000; i++)
+		found += (plain.contains(i) ? 1 : 0) + (bloom.contains(i) ? 1 : 0);
+	EXPECT_EQ(plain.size(), 5000U);
+	EXPECT_EQ(found, 10000U);
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}
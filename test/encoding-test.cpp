@@ -0,0 +1,113 @@
+#include <cxx_argp_encoding.h>
+
+#include <iostream>
+#include <string>
+
+#include "test.h"
+
+// creating real argv-strings here
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+
+static std::string to_hex(const std::vector<uint8_t> &data, bool upper)
+{
+	const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	std::string s;
+	for (auto byte : data) {
+		s += digits[byte >> 4];
+		s += digits[byte & 15];
+	}
+	return s;
+}
+
+static std::string to_base64(const std::vector<uint8_t> &data)
+{
+	const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string s;
+	for (size_t i = 0; i < data.size(); i += 3) {
+		uint32_t bits = data[i] << 16;
+		if (i + 1 < data.size())
+			bits |= data[i + 1] << 8;
+		if (i + 2 < data.size())
+			bits |= data[i + 2];
+		s += alphabet[bits >> 18];
+		s += alphabet[(bits >> 12) & 63];
+		s += i + 1 < data.size() ? alphabet[(bits >> 6) & 63] : '=';
+		s += i + 2 < data.size() ? alphabet[bits & 63] : '=';
+	}
+	return s;
+}
+
+TEST(Encoding, options)
+{
+	char *argv[] = {"program-name",
+	                "--seed", "00112233445566778899aAbBcCdDeEfF", "--key", "AAECAw==", "--blob", "aGVsbG8="};
+
+	std::vector<uint8_t> seed, blob;
+	std::array<uint8_t, 4> key;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"seed", 's', "HEX", 0, "seed"}, cxx_argp::hex(seed));
+	parser.add_option({"key", 'k', "BASE64", 0, "key"}, cxx_argp::base64(key));
+	parser.add_option({"blob", 'b', "BASE64", 0, "blob"}, cxx_argp::base64(blob));
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	ASSERT_EQ(seed.size(), 16U);
+	EXPECT_EQ(seed[1], 0x11);
+	EXPECT_EQ(seed[10], 0xaa);
+	EXPECT_EQ(seed[15], 0xff);
+	EXPECT_EQ(key[3], 3);
+	EXPECT_EQ(std::string(blob.begin(), blob.end()), "hello");
+
+	std::string message;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::hex(seed), 's', "0011223344556677889g", message), EINVAL);
+	EXPECT_EQ(message.find("'g' at offset 19") != std::string::npos, true);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::hex(seed), 's', "001", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::base64(key), 'k', "AAECAwQ=", message), EINVAL);
+	EXPECT_EQ(message.find("5 bytes instead of 4") != std::string::npos, true);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::base64(blob), 'b', "aGV=bG8=", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::base64(blob), 'b', "aGVsbG8", message), EINVAL);
+}
+
+TEST(Encoding, round_trip)
+{
+	std::vector<uint8_t> data;
+	uint32_t x = 12345;
+	for (size_t size = 0; size < 100; size++) {
+		std::vector<uint8_t> decoded;
+
+		std::string message;
+		for (auto upper : {false, true}) {
+			EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::hex(decoded), 'x', to_hex(data, upper).c_str(), message), 0);
+			EXPECT_EQ(decoded == data, true);
+		}
+		EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::base64(decoded), 'x', to_base64(data).c_str(), message), 0);
+		EXPECT_EQ(decoded == data, true);
+
+		x = x * 1103515245 + 12345;
+		data.push_back(x >> 16);
+	}
+
+	// an invalid character in each position of the vectorized part
+	std::string hex = to_hex(data, false);
+	for (size_t i = 0; i < 40; i++) {
+		std::string invalid = hex;
+		invalid[i] = i % 2 ? 'G' : '\xe0';
+		std::vector<uint8_t> decoded(data.size());
+		EXPECT_EQ(cxx_argp::decode_hex(invalid.data(), invalid.size(), decoded.data()), i);
+	}
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}
@@ -0,0 +1,167 @@
+#include <cxx_argp_files.h>
+
+#include <iostream>
+
+#include "test.h"
+
+// creating real argv-strings here
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+
+TEST(Files, mapped_file)
+{
+	char *argv[] = {"program-name",
+	                "-m", "/etc/passwd"};
+
+	cxx_argp::mapped_file file{cxx_argp::mapped_file::sequential |
+	                           cxx_argp::mapped_file::hugepage};
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"map", 'm', "filename", 0, "a mapped file"}, file);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	std::ifstream stream{"/etc/passwd"};
+	std::string content{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+
+	EXPECT_EQ(file.is_open(), true);
+	EXPECT_EQ(file.name(), "/etc/passwd");
+	EXPECT_EQ(std::string(file.begin(), file.end()), content);
+}
+
+TEST(Files, mapped_file_missing)
+{
+	char *argv[] = {"program-name",
+	                "-m", "/should-not-exist"};
+
+	cxx_argp::mapped_file file;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"map", 'm', "filename", 0, "a mapped file"}, file);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+	EXPECT_EQ(file.is_open(), false);
+}
+
+TEST(Files, file_descriptor)
+{
+	char *argv[] = {"program-name",
+	                "-i", "/etc/passwd", "-o", "/tmp/cxx-argp-files-test.out"};
+
+	cxx_argp::file_descriptor input{O_RDONLY | O_CLOEXEC, 0, 0, POSIX_FADV_SEQUENTIAL};
+	cxx_argp::file_descriptor output{O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600, 1 << 20};
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"input", 'i', "filename", 0, "an input file"}, input);
+	parser.add_option({"output", 'o', "filename", 0, "an output file"}, output);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(input.is_open(), true);
+	EXPECT_EQ(output.is_open(), true);
+	EXPECT_EQ(output.name(), "/tmp/cxx-argp-files-test.out");
+
+	struct stat st;
+	ASSERT_EQ(fstat(output.get(), &st), 0);
+	EXPECT_EQ(st.st_size, 1 << 20);
+
+	unlink("/tmp/cxx-argp-files-test.out");
+}
+
+TEST(Files, file_descriptor_missing)
+{
+	char *argv[] = {"program-name",
+	                "-i", "/should-not-exist"};
+
+	cxx_argp::file_descriptor input;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"input", 'i', "filename", 0, "an input file"}, input);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+	EXPECT_EQ(input.is_open(), false);
+}
+
+static void test_file_list(bool io_uring)
+{
+	char *argv[] = {"program-name",
+	                "-f", "/etc/passwd", "-f", "/bin/sh", "-f", "/etc/group"};
+
+	cxx_argp::file_list files{O_RDONLY | O_CLOEXEC, io_uring};
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"file", 'f', "filename", 0, "an input file"}, files);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	ASSERT_EQ(files.size(), 3U);
+	EXPECT_EQ(files[1].descriptor.name(), "/bin/sh");
+	EXPECT_EQ(files[1].descriptor.is_open(), true);
+
+	struct stat st;
+	ASSERT_EQ(stat("/etc/group", &st), 0);
+	EXPECT_EQ(files[2].status.st_ino, st.st_ino);
+}
+
+TEST(Files, file_list_io_uring)
+{
+	test_file_list(true);
+}
+
+TEST(Files, file_list_threads)
+{
+	test_file_list(false);
+}
+
+TEST(Files, file_list_missing)
+{
+	char *argv[] = {"program-name",
+	                "-f", "/should-not-exist", "-f", "/etc/passwd", "-f", "/should-not-exist-either"};
+
+	cxx_argp::file_list files;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"file", 'f', "filename", 0, "an input file"}, files);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), false);
+	EXPECT_EQ(files.size(), 1U);
+}
+
+TEST(Files, file_list_arguments)
+{
+	char *argv[] = {"program-name",
+	                "output", "/etc/passwd", "/etc/group"};
+
+	std::string output;
+	cxx_argp::file_list inputs;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_argument(output);
+	parser.add_argument(inputs);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(output, "output");
+	ASSERT_EQ(inputs.size(), 2U);
+	EXPECT_EQ(inputs[1].descriptor.name(), "/etc/group");
+	EXPECT_EQ(inputs[1].descriptor.is_open(), true);
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}
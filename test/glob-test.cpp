@@ -0,0 +1,103 @@
+#include <cxx_argp_glob.h>
+
+#include <fnmatch.h>
+
+#include <iostream>
+
+#include "test.h"
+
+// creating real argv-strings here
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+
+TEST(Glob, include_exclude)
+{
+	char *argv[] = {"program-name",
+	                "--include", "*.cpp", "-i", "src/*.[ch]", "-i", "README.??",
+	                "--exclude", "*test*"};
+
+	cxx_argp::glob_set include, exclude;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"include", 'i', "GLOB", 0, "include files"}, include);
+	parser.add_option({"exclude", 'e', "GLOB", 0, "exclude files"}, exclude);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(include.size(), 3U);
+	EXPECT_EQ(include.matches("main.cpp"), true);
+	EXPECT_EQ(include.matches("dir/main.cpp"), true);
+	EXPECT_EQ(include.matches("main.cpp.orig"), false);
+	EXPECT_EQ(include.matches("src/parser.h"), true);
+	EXPECT_EQ(include.matches("src/parser.hpp"), false);
+	EXPECT_EQ(include.matches("README.md"), true);
+	EXPECT_EQ(include.matches("README.txt"), false);
+
+	EXPECT_EQ(exclude.matches("basic-test.cpp"), true);
+	EXPECT_EQ(exclude.matches("basic.cpp"), false);
+
+	cxx_argp::glob_set none;
+	EXPECT_EQ(none.matches(""), false);
+}
+
+// same result as matching with fnmatch() one pattern after the other
+TEST(Glob, like_fnmatch)
+{
+	const char *patterns[] = {
+		"*", "a*b", "*a*b*c", "?", "[abc]x", "[!abc]x", "[]]", "[a-]", "[z-a]",
+		"\\*", "[", "x[y", "**b", "*.[ch]", "a?c*", "[^0-9]*",
+	};
+	const char *texts[] = {
+		"", "a", "ab", "axb", "axbyc", "bx", "dx", "]", "-", "*", "a\\", "[",
+		"x[y", "b", "bb", "main.c", "main.cc", "abc", "abcd", "0abc", "zabc",
+	};
+
+	for (auto pattern : patterns) {
+		cxx_argp::glob_set one;
+		one.add(pattern);
+		for (auto text : texts)
+			if (one.matches(text) != (fnmatch(pattern, text, 0) == 0))
+				EXPECT_EQ(std::string(pattern) + " " + text, "");
+	}
+
+	cxx_argp::glob_set all;
+	for (auto pattern : patterns)
+		if (strcmp(pattern, "*") != 0)
+			all.add(pattern);
+	for (auto text : texts) {
+		bool any = false;
+		for (auto pattern : patterns)
+			if (strcmp(pattern, "*") != 0)
+				any |= fnmatch(pattern, text, 0) == 0;
+		EXPECT_EQ(all.matches(text), any);
+	}
+}
+
+TEST(Glob, many_patterns)
+{
+	cxx_argp::glob_set set;
+	for (int i = 0; i < 500; i++)
+		set.add(("*/file-" + std::to_string(i) + ".*").c_str());
+
+	EXPECT_EQ(set.matches("dir/file-499.txt"), true);
+	EXPECT_EQ(set.matches("dir/file-500.txt"), false);
+	EXPECT_EQ(set.matches("file-1.txt"), false);
+
+	int matched = 0;
+	for (int i = 0; i < 2000; i++)
+		matched += set.matches("a/b/file-" + std::to_string(i) + ".log");
+	EXPECT_EQ(matched, 500);
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}
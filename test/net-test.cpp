@@ -0,0 +1,96 @@
+#include <cxx_argp_net.h>
+
+#include <iostream>
+
+#include "test.h"
+
+// creating real argv-strings here
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+
+TEST(Net, addresses)
+{
+	char *argv[] = {"program-name",
+	                "-a", "192.0.2.1", "-b", "[2001:db8::1]:443", "-c", "127.0.0.1:8080"};
+
+	cxx_argp::address a;
+	cxx_argp::endpoint b, c;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({nullptr, 'a', "ADDRESS", 0, "address"}, a);
+	parser.add_option({nullptr, 'b', "ENDPOINT", 0, "endpoint"}, b);
+	parser.add_option({nullptr, 'c', "ENDPOINT", 0, "endpoint"}, c);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(a.family(), AF_INET);
+	EXPECT_EQ(a.str(), "192.0.2.1");
+	EXPECT_EQ(b.family(), AF_INET6);
+	EXPECT_EQ(b.str(), "2001:db8::1");
+	EXPECT_EQ(b.port(), 443);
+	EXPECT_EQ(b.size(), sizeof(struct sockaddr_in6));
+	EXPECT_EQ(c.port(), 8080);
+
+	std::string message;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(a), 'a', "192.0.2", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(b), 'b', "2001:db8::1:443", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(b), 'b', "[::1]", message), EINVAL);
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(b), 'b', "127.0.0.1:65536", message), EINVAL);
+}
+
+static bool allowed(const cxx_argp::cidr_list &list, const char *text)
+{
+	cxx_argp::address a;
+	return a.assign(text, strlen(text)) && list.contains(a);
+}
+
+TEST(Net, cidr_list)
+{
+	char *argv[] = {"program-name",
+	                "--allow", "10.0.0.0/8,192.168.1.7/24", "--allow", "10.1.0.0/16,2001:db8::/32,0.0.0.0/32"};
+
+	cxx_argp::cidr_list allow;
+
+	cxx_argp::parser parser;
+	parser.add_flags(ARGP_NO_EXIT);
+	parser.add_option({"allow", 'a', "CIDR,...", 0, "allowed networks"}, allow);
+
+	ASSERT_EQ(parser.parse(sizeof(argv) / sizeof(argv[0]), argv), true);
+
+	EXPECT_EQ(allow.size(), 4U); // 10.1.0.0/16 merged into 10.0.0.0/8
+	EXPECT_EQ(allowed(allow, "10.255.255.255"), true);
+	EXPECT_EQ(allowed(allow, "11.0.0.0"), false);
+	EXPECT_EQ(allowed(allow, "192.168.1.0"), true);
+	EXPECT_EQ(allowed(allow, "192.168.2.0"), false);
+	EXPECT_EQ(allowed(allow, "0.0.0.0"), true);
+	EXPECT_EQ(allowed(allow, "0.0.0.1"), false);
+	EXPECT_EQ(allowed(allow, "::ffff:10.2.3.4"), true);
+	EXPECT_EQ(allowed(allow, "2001:db8:ffff::1"), true);
+	EXPECT_EQ(allowed(allow, "2001:db9::"), false);
+
+	std::string message;
+	EXPECT_EQ(cxx_argp::convert_silently(cxx_argp::make_check_function(allow), 'a', "1.2.3.4/8,1.2.3.4/33", message), EINVAL);
+	EXPECT_EQ(message.find("'1.2.3.4/33' is not") != std::string::npos, true);
+}
+
+TEST(Net, cidr_list_all)
+{
+	cxx_argp::cidr_list all;
+	ASSERT_EQ(all.add_list("0.0.0.0/0,::/0,255.255.255.255"), true);
+	EXPECT_EQ(all.size(), 2U);
+	EXPECT_EQ(allowed(all, "255.255.255.255"), true);
+	EXPECT_EQ(allowed(all, "ffff::"), true);
+}
+
+int main(void)
+{
+	for (auto &t : tests__)
+		t();
+
+	if (result__)
+		std::cerr << result__ << " test-condition(s) failed\n";
+	else
+		std::cerr << "all tests OK\n";
+
+	return result__;
+}